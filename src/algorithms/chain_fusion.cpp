@@ -0,0 +1,74 @@
+#include <iostream>
+#include <boost/format.hpp>
+#include "algorithms/chain_fusion.hpp"
+#include "algorithms/csr_graph.hpp"
+#include "util/output.hpp"
+#include "util/scope_profile.hpp"
+
+namespace sched_bench { namespace algorithms {
+
+Fused_graph fuse_chains(Graph const &graph, util::Array_view<double> costs, double max_cost_ms) {
+    SCOPE_PROFILE("Fuse Chains");
+    auto const csr = to_csr_graph(graph);
+    auto const count = csr.node_count();
+
+    // the only distinct child and parent of every node, NO_NODE when there is none and SEVERAL when there are more
+    static const uint SEVERAL = Csr_graph::NO_NODE - 1;
+    std::vector<uint> child(count, Csr_graph::NO_NODE);
+    std::vector<uint> parent(count, Csr_graph::NO_NODE);
+    for (uint node = 0; node < count; node++) {
+        for (uint l = csr.offsets[node]; l < csr.offsets[node + 1]; l++) {
+            auto target = csr.targets[l];
+            child[node] = (child[node] == Csr_graph::NO_NODE || child[node] == target) ? target : SEVERAL;
+            parent[target] = (parent[target] == Csr_graph::NO_NODE || parent[target] == node) ? node : SEVERAL;
+        }
+    }
+
+    auto linear = [&](uint node) {
+        auto p = parent[node];
+        return p < SEVERAL && child[p] == node;
+    };
+
+    Fused_graph result;
+    std::vector<bool> follows(count, false);
+    uint dispatches = 0;
+    {
+        SCOPE_PROFILE("Walk Chains");
+        // every chain starts at a node that cannot follow its parent and is cut into units by the cost cap
+        for (uint head = 0; head < count; head++) {
+            if (linear(head)) {
+                continue;
+            }
+
+            uint unit = head;
+            double cost = costs[csr.ids[head].as_numeric()];
+            dispatches++;
+            for (uint node = child[head]; node < SEVERAL && linear(node); node = child[node]) {
+                double node_cost = costs[csr.ids[node].as_numeric()];
+                if (cost + node_cost > max_cost_ms) {
+                    unit = node;
+                    cost = node_cost;
+                    dispatches++;
+                    continue;
+                }
+
+                follows[node] = true;
+                cost += node_cost;
+                result.chains[csr.ids[unit]].push_back(csr.ids[node]);
+            }
+        }
+    }
+
+    // a follower's only links in are from the transaction before it in its dispatch, everything else links units
+    result.graph.roots = graph.roots;
+    for (auto const &l: graph.links) {
+        if (!follows[csr.index_by_id[l.second.as_numeric()]]) {
+            result.graph.links.emplace_hint(result.graph.links.end(), l.first, l.second);
+        }
+    }
+
+    util::output() << boost::format {"Chain Fusion: %d dispatches before, %d after\n"} % count % dispatches;
+    return result;
+}
+
+}}
@@ -0,0 +1,292 @@
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <queue>
+#include <boost/format.hpp>
+#include "algorithms/component_partition.hpp"
+#include "algorithms/delay_conflicts.hpp"
+#include "util/output.hpp"
+#include "util/scope_profile.hpp"
+
+namespace sched_bench { namespace algorithms {
+
+namespace {
+
+static const uint NONE = ~0u;
+
+// union by size with path halving over dense ids
+struct Disjoint_set {
+    explicit Disjoint_set(uint count)
+        : parent(count)
+        , size(count, 1)
+    {
+        for (uint i = 0; i < count; i++) {
+            parent[i] = i;
+        }
+    }
+
+    uint find(uint i) {
+        while (parent[i] != i) {
+            parent[i] = parent[parent[i]];
+            i = parent[i];
+        }
+        return i;
+    }
+
+    void unite(uint l, uint r) {
+        l = find(l);
+        r = find(r);
+        if (l == r) {
+            return;
+        }
+
+        if (size[l] < size[r]) {
+            std::swap(l, r);
+        }
+        parent[r] = l;
+        size[l] += size[r];
+    }
+
+    std::vector<uint> parent;
+    std::vector<uint> size;
+};
+
+}
+
+Standard_Block partition_by_component(std::vector<Transaction> const &transactions, util::Array_view<double> costs, uint thread_count) {
+    thread_count = std::max(1u, thread_count);
+    std::vector<Standard_Block::Entry> schedule;
+    schedule.reserve(transactions.size());
+
+    // only accounts that something writes can make two transactions conflict, shared reads never join components
+    std::vector<bool> written;
+    {
+        SCOPE_PROFILE("Find Written Accounts");
+        uint max_account = 0;
+        for (auto const &t: transactions) {
+            for (auto const &a_id: t.accounts) {
+                max_account = std::max(max_account, a_id.as_numeric() + 1);
+            }
+        }
+
+        written.resize(max_account);
+        for (auto const &t: transactions) {
+            for (auto const &a_id: t.writes()) {
+                written[a_id.as_numeric()] = true;
+            }
+        }
+    }
+
+    Disjoint_set accounts(written.size());
+    {
+        SCOPE_PROFILE("Union Accounts");
+        for (auto const &t: transactions) {
+            uint first = NONE;
+            for (auto const &a_id: t.accounts) {
+                if (!written[a_id.as_numeric()]) {
+                    continue;
+                }
+
+                if (first == NONE) {
+                    first = a_id.as_numeric();
+                } else {
+                    accounts.unite(first, a_id.as_numeric());
+                }
+            }
+        }
+    }
+
+    // dense component indices in order of first appearance, a transaction with no written account is a component alone
+    std::vector<uint> component_of(transactions.size());
+    std::vector<double> component_cost;
+    {
+        SCOPE_PROFILE("Label Components");
+        std::vector<uint> component_by_root(written.size(), NONE);
+        for (uint i = 0; i < transactions.size(); i++) {
+            auto const &t = transactions[i];
+            uint root = NONE;
+            for (auto const &a_id: t.accounts) {
+                if (written[a_id.as_numeric()]) {
+                    root = accounts.find(a_id.as_numeric());
+                    break;
+                }
+            }
+
+            uint component;
+            if (root == NONE) {
+                component = component_cost.size();
+                component_cost.push_back(0.0);
+            } else {
+                if (component_by_root[root] == NONE) {
+                    component_by_root[root] = component_cost.size();
+                    component_cost.push_back(0.0);
+                }
+                component = component_by_root[root];
+            }
+
+            component_of[i] = component;
+            component_cost[component] += costs[t.id.as_numeric()];
+        }
+    }
+
+    // components costing more than an even share of the block, scheduled like delay_conflicts
+    std::vector<bool> oversized(component_cost.size(), false);
+    std::vector<uint> by_cost(component_cost.size());
+    std::vector<Transaction> oversized_transactions;
+    {
+        SCOPE_PROFILE("Find Oversized Components");
+        double total_cost = 0.0;
+        for (auto const &c: component_cost) {
+            total_cost += c;
+        }
+        double const even_share = total_cost / thread_count;
+
+        for (uint i = 0; i < by_cost.size(); i++) {
+            by_cost[i] = i;
+            // with a single thread every component runs serially anyway, there is nothing to gain from cycles
+            oversized[i] = thread_count > 1 && component_cost[i] > even_share;
+        }
+        std::stable_sort(by_cost.begin(), by_cost.end(), [&component_cost](uint l, uint r) {
+            return component_cost[l] > component_cost[r];
+        });
+
+        for (uint i = 0; i < transactions.size(); i++) {
+            if (oversized[component_of[i]]) {
+                oversized_transactions.push_back(transactions[i]);
+            }
+        }
+    }
+
+    // the oversized components come first, their cycles would otherwise wait at every barrier for the packed spans
+    std::vector<Standard_Block::Entry> delayed;
+    if (!oversized_transactions.empty()) {
+        delayed = delay_conflicts_bitset(oversized_transactions).transactions;
+    }
+    uint const delayed_cycles = delayed.empty() ? 0 : delayed.back().cycle + 1;
+
+    // every component that is not oversized runs as one span, in a delayed cycle or in a last cycle of its own
+    std::vector<uint> cycle_of(component_cost.size(), NONE);
+    std::vector<uint> thread_of(component_cost.size(), NONE);
+    std::vector<uint> packed_width(delayed_cycles, 0);
+    {
+        SCOPE_PROFILE("Pack Components");
+        // a cycle lasts at least as long as its most expensive span and its work spread over every thread
+        std::vector<uint> cycle_width(delayed_cycles, 0);
+        std::vector<double> cycle_longest(delayed_cycles, 0.0);
+        std::vector<double> cycle_work(delayed_cycles, 0.0);
+        for (auto const &e: delayed) {
+            double cost = costs[e.tid.as_numeric()];
+            cycle_width[e.cycle] = std::max(cycle_width[e.cycle], e.thread + 1);
+            cycle_longest[e.cycle] = std::max(cycle_longest[e.cycle], cost);
+            cycle_work[e.cycle] += cost;
+        }
+
+        auto cycle_length = [&](uint c) {
+            return std::max(cycle_longest[c], cycle_work[c] / thread_count);
+        };
+
+        /**
+         * A delayed cycle with fewer spans than threads starts all of them at its barrier and lasts as long as its most
+         * expensive transaction, its idle threads take components up to that length without making the cycle any
+         * longer.  Spans added to a cycle any other way are numbered after the idle threads.
+         */
+        struct Slot {
+            uint cycle;
+            uint thread;
+        };
+
+        // the idle threads by the room left on them
+        std::multimap<double, Slot> slots;
+        std::vector<uint> next_thread(delayed_cycles, 0);
+        for (uint c = 0; c < delayed_cycles; c++) {
+            for (uint thread = cycle_width[c]; thread < thread_count; thread++) {
+                slots.emplace(cycle_longest[c], Slot {c, next_thread[c]++});
+            }
+        }
+
+        // the last cycle's threads, the least loaded first
+        typedef std::pair<double, uint> Load;
+        std::priority_queue<Load, std::vector<Load>, std::greater<Load>> loads;
+        for (uint thread = 0; thread < thread_count; thread++) {
+            loads.emplace(0.0, thread);
+        }
+        double last_length = 0.0;
+
+        // the delayed cycles, the longest first, a cycle is pushed again when it grows and the stale entries are skipped
+        std::priority_queue<std::pair<double, uint>> longest_cycles;
+        for (uint c = 0; c < delayed_cycles; c++) {
+            longest_cycles.emplace(cycle_length(c), c);
+        }
+
+        auto place = [&](uint component, uint cycle, uint thread) {
+            cycle_of[component] = cycle;
+            thread_of[component] = thread;
+            if (cycle < delayed_cycles) {
+                double length = cycle_length(cycle);
+                cycle_longest[cycle] = std::max(cycle_longest[cycle], component_cost[component]);
+                cycle_work[cycle] += component_cost[component];
+                packed_width[cycle] = std::max(packed_width[cycle], thread + 1);
+                if (cycle_length(cycle) != length) {
+                    longest_cycles.emplace(cycle_length(cycle), cycle);
+                }
+            }
+        };
+
+        // largest first, on the idle thread it fits best or wherever it makes the schedule the least longer
+        for (auto component: by_cost) {
+            if (oversized[component]) {
+                continue;
+            }
+
+            double cost = component_cost[component];
+            auto slot = slots.lower_bound(cost);
+            if (slot != slots.end()) {
+                auto taken = *slot;
+                slots.erase(slot);
+                slots.emplace(taken.first - cost, taken.second);
+                place(component, taken.second.cycle, taken.second.thread);
+                continue;
+            }
+
+            // the longest delayed cycle has the most room, it is taken unless the last cycle would grow less
+            while (!longest_cycles.empty() && longest_cycles.top().first != cycle_length(longest_cycles.top().second)) {
+                longest_cycles.pop();
+            }
+
+            auto least = loads.top();
+            double last_growth = std::max(last_length, least.first + cost) - last_length;
+            if (!longest_cycles.empty()) {
+                uint c = longest_cycles.top().second;
+                double grown = std::max({cycle_longest[c], cost, (cycle_work[c] + cost) / thread_count});
+                if (grown - cycle_length(c) < last_growth) {
+                    place(component, c, next_thread[c]++);
+                    continue;
+                }
+            }
+
+            loads.pop();
+            loads.emplace(least.first + cost, least.second);
+            last_length = std::max(last_length, least.first + cost);
+            place(component, delayed_cycles, least.second);
+        }
+
+        for (uint i = 0; i < transactions.size(); i++) {
+            auto component = component_of[i];
+            if (!oversized[component]) {
+                schedule.emplace_back(cycle_of[component], thread_of[component], transactions[i].id);
+            }
+        }
+
+        // the packed spans of a delayed cycle are numbered, and so dispatched, before its own transactions
+        for (auto const &e: delayed) {
+            schedule.emplace_back(e.cycle, e.thread + packed_width[e.cycle], e.tid);
+        }
+    }
+
+    util::output() << boost::format {"Components: %d, %d transactions in oversized components\n"} % component_cost.size() % oversized_transactions.size();
+
+    return Standard_Block(schedule);
+}
+
+}}
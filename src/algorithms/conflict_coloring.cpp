@@ -0,0 +1,266 @@
+#include <algorithm>
+#include <cstdint>
+#include "algorithms/conflict_coloring.hpp"
+#include "util/scope_profile.hpp"
+
+namespace sched_bench { namespace algorithms {
+
+namespace {
+
+// a growable bitset of cycles
+struct Color_set {
+    std::vector<uint64_t> words;
+
+    bool contains(uint color) const {
+        uint word = color / 64;
+        return word < words.size() && (words[word] >> (color % 64)) & 1;
+    }
+
+    void insert(uint color) {
+        uint word = color / 64;
+        if (word >= words.size()) {
+            words.resize(word + 1, 0);
+        }
+        words[word] |= uint64_t(1) << (color % 64);
+    }
+
+    uint64_t word(uint index) const {
+        return index < words.size() ? words[index] : 0;
+    }
+};
+
+/**
+ * The transactions on every dense account, its writers first, and the cycles those writers and readers were colored
+ * with.  This stands in for the conflict graph, whose cliques on popular accounts would be quadratic in size.
+ */
+struct Conflicts {
+    explicit Conflicts(std::vector<Transaction> const &_transactions)
+        : transactions(_transactions)
+    {
+        SCOPE_PROFILE("Index Accounts");
+        uint max_account = 0;
+        for (auto const &t: transactions) {
+            for (auto const &a_id: t.accounts) {
+                max_account = std::max(max_account, a_id.as_numeric() + 1);
+            }
+        }
+
+        std::vector<uint> write_counts(max_account, 0);
+        offsets.assign(max_account + 1, 0);
+        for (auto const &t: transactions) {
+            for (uint a = 0; a < t.accounts.size(); a++) {
+                offsets[t.accounts[a].as_numeric() + 1]++;
+                if (t.writes_account(a)) {
+                    write_counts[t.accounts[a].as_numeric()]++;
+                }
+            }
+        }
+
+        for (uint i = 0; i < max_account; i++) {
+            offsets[i + 1] += offsets[i];
+        }
+
+        std::vector<uint> write_cursor(offsets.begin(), offsets.end() - 1);
+        std::vector<uint> read_cursor(max_account);
+        write_end.resize(max_account);
+        for (uint i = 0; i < max_account; i++) {
+            write_end[i] = offsets[i] + write_counts[i];
+            read_cursor[i] = write_end[i];
+        }
+
+        members.resize(offsets.back());
+        for (uint i = 0; i < transactions.size(); i++) {
+            auto const &t = transactions[i];
+            for (uint a = 0; a < t.accounts.size(); a++) {
+                auto account = t.accounts[a].as_numeric();
+                members[t.writes_account(a) ? write_cursor[account]++ : read_cursor[account]++] = i;
+            }
+        }
+
+        writer_colors.resize(max_account);
+        reader_colors.resize(max_account);
+    }
+
+    // conflicts counted once per shared account, transactions sharing several accounts are counted more than once
+    uint degree(uint index) const {
+        auto const &t = transactions[index];
+        uint result = 0;
+        for (uint a = 0; a < t.accounts.size(); a++) {
+            auto account = t.accounts[a].as_numeric();
+            // a writer conflicts with everything else on the account, a reader only with its writers
+            if (t.writes_account(a)) {
+                result += offsets[account + 1] - offsets[account] - 1;
+            } else {
+                result += write_end[account] - offsets[account];
+            }
+        }
+        return result;
+    }
+
+    // the lowest cycle that none of the transaction's colored conflicts use
+    uint lowest_free(uint index) const {
+        auto const &t = transactions[index];
+        for (uint w = 0; ; w++) {
+            uint64_t used = 0;
+            for (uint a = 0; a < t.accounts.size(); a++) {
+                auto account = t.accounts[a].as_numeric();
+                used |= writer_colors[account].word(w);
+                if (t.writes_account(a)) {
+                    used |= reader_colors[account].word(w);
+                }
+            }
+
+            if (~used != 0) {
+                return w * 64 + __builtin_ctzll(~used);
+            }
+        }
+    }
+
+    // colors the transaction and calls fn(account) for every account that had not seen the color before
+    template<typename FN>
+    void mark(uint index, uint color, FN fn) {
+        auto const &t = transactions[index];
+        for (uint a = 0; a < t.accounts.size(); a++) {
+            auto account = t.accounts[a].as_numeric();
+            if (!writer_colors[account].contains(color) && !reader_colors[account].contains(color)) {
+                fn(account);
+            }
+            (t.writes_account(a) ? writer_colors[account] : reader_colors[account]).insert(color);
+        }
+    }
+
+    std::vector<Transaction> const &transactions;
+    std::vector<uint> offsets;
+    std::vector<uint> write_end;
+    std::vector<uint> members;
+    std::vector<Color_set> writer_colors;
+    std::vector<Color_set> reader_colors;
+};
+
+// the transactions with the most conflicts first, ties in input order
+std::vector<uint> degree_order(Conflicts const &conflicts) {
+    auto const count = conflicts.transactions.size();
+    std::vector<uint> degree(count);
+    std::vector<uint> order(count);
+    for (uint i = 0; i < count; i++) {
+        degree[i] = conflicts.degree(i);
+        order[i] = i;
+    }
+
+    std::stable_sort(order.begin(), order.end(), [&degree](uint l, uint r) {
+        return degree[l] > degree[r];
+    });
+    return order;
+}
+
+// every transaction is its own span, the threads of a cycle are numbered in the order they were colored
+struct Block_builder {
+    explicit Block_builder(std::size_t size) {
+        schedule.reserve(size);
+    }
+
+    void add(uint color, Transaction::Id id) {
+        if (color >= widths.size()) {
+            widths.resize(color + 1, 0);
+        }
+        schedule.emplace_back(color, widths[color]++, id);
+    }
+
+    std::vector<Standard_Block::Entry> schedule;
+    std::vector<uint> widths;
+};
+
+}
+
+Standard_Block color_by_saturation(std::vector<Transaction> const &transactions) {
+    Conflicts conflicts(transactions);
+    Block_builder builder(transactions.size());
+
+    {
+        SCOPE_PROFILE("Color Transactions");
+        auto const account_count = conflicts.writer_colors.size();
+        std::vector<uint> saturation(account_count, 0);
+        std::vector<uint> cursor(conflicts.offsets.begin(), conflicts.offsets.end() - 1);
+        std::vector<bool> colored(transactions.size(), false);
+
+        /**
+         * A bucket queue of accounts over saturation whose max pointer only moves up when an account is pushed.
+         * Saturation only grows, so accounts are pushed again rather than moved and the stale entries are skipped.  The
+         * first bucket holds the accounts with the most transactions last so they are colored first.
+         */
+        std::vector<std::vector<uint>> buckets(1);
+        buckets[0].resize(account_count);
+        for (uint a = 0; a < account_count; a++) {
+            buckets[0][a] = a;
+        }
+        std::stable_sort(buckets[0].begin(), buckets[0].end(), [&conflicts](uint l, uint r) {
+            return conflicts.offsets[l + 1] - conflicts.offsets[l] < conflicts.offsets[r + 1] - conflicts.offsets[r];
+        });
+        uint top = 0;
+
+        auto push = [&](uint account) {
+            uint s = ++saturation[account];
+            if (s >= buckets.size()) {
+                buckets.resize(s + 1);
+            }
+            buckets[s].push_back(account);
+            top = std::max(top, s);
+        };
+
+        auto color = [&](uint index) {
+            colored[index] = true;
+            uint c = conflicts.lowest_free(index);
+            builder.add(c, transactions[index].id);
+            conflicts.mark(index, c, push);
+        };
+
+        while (true) {
+            while (top > 0 && buckets[top].empty()) {
+                top--;
+            }
+            if (buckets[top].empty()) {
+                break;
+            }
+
+            // the account stays on top until it is exhausted or a push makes this entry stale
+            uint account = buckets[top].back();
+            auto &next = cursor[account];
+            while (next < conflicts.offsets[account + 1] && colored[conflicts.members[next]]) {
+                next++;
+            }
+            if (saturation[account] != top || next == conflicts.offsets[account + 1]) {
+                buckets[top].pop_back();
+                continue;
+            }
+
+            color(conflicts.members[next]);
+        }
+
+        // transactions without accounts conflict with nothing
+        for (uint i = 0; i < transactions.size(); i++) {
+            if (!colored[i]) {
+                color(i);
+            }
+        }
+    }
+
+    return Standard_Block(builder.schedule);
+}
+
+Standard_Block color_by_degree(std::vector<Transaction> const &transactions) {
+    Conflicts conflicts(transactions);
+    Block_builder builder(transactions.size());
+
+    {
+        SCOPE_PROFILE("Color Transactions");
+        for (auto index: degree_order(conflicts)) {
+            uint color = conflicts.lowest_free(index);
+            builder.add(color, transactions[index].id);
+            conflicts.mark(index, color, [](uint) {});
+        }
+    }
+
+    return Standard_Block(builder.schedule);
+}
+
+}}
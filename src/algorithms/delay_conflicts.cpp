@@ -0,0 +1,261 @@
+#include <algorithm>
+#include <cstdint>
+#include "algorithms/delay_conflicts.hpp"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && !defined(DELAY_CONFLICTS_NO_SIMD)
+#include <immintrin.h>
+#define DELAY_CONFLICTS_HAS_AVX2 1
+#endif
+
+namespace sched_bench { namespace algorithms {
+using sched_bench::model::Account;
+
+namespace {
+
+// accounts are tracked modulo this many slots, exactly as delay_conflicts does, with a written and a read bit each
+static const uint TRACKED_ACCOUNTS = 1024 * 1024;
+static const uint WORD_BITS = 64;
+static const uint SLOTS_PER_WORD = WORD_BITS / 2;
+static const uint WORD_COUNT = TRACKED_ACCOUNTS / SLOTS_PER_WORD;
+
+// within a slot's two bits the low bit is written and the high bit is read, a write conflicts with either
+static const uint64_t WRITTEN_BIT = 1;
+static const uint64_t READ_BIT = 2;
+
+static_assert((TRACKED_ACCOUNTS & (TRACKED_ACCOUNTS - 1)) == 0, "tracked accounts must be a power of two");
+static_assert(sizeof(Account::Id) == sizeof(uint32_t), "account ids are loaded as u32 lanes");
+
+/**
+ * Two bits per tracked account in 32-byte aligned words.  Every word that goes from zero to non-zero is remembered so
+ * that a reset only clears the words used during the cycle.
+ */
+struct Account_bitset {
+    Account_bitset()
+        : storage(WORD_COUNT + 4, 0)
+    {
+        auto address = reinterpret_cast<std::uintptr_t>(storage.data());
+        words = storage.data() + ((32 - (address & 31)) & 31) / sizeof(uint64_t);
+        touched.reserve(WORD_COUNT);
+    }
+
+    // a write conflicts with earlier reads and writes, a read only with earlier writes
+    bool conflicts(uint32_t slot, bool write) const {
+        return (words[slot / SLOTS_PER_WORD] >> (slot % SLOTS_PER_WORD * 2)) & (write ? WRITTEN_BIT | READ_BIT : WRITTEN_BIT);
+    }
+
+    void set(uint32_t slot, bool write) {
+        auto &word = words[slot / SLOTS_PER_WORD];
+        if (word == 0) {
+            touched.push_back(slot / SLOTS_PER_WORD);
+        }
+        word |= (write ? WRITTEN_BIT : READ_BIT) << (slot % SLOTS_PER_WORD * 2);
+    }
+
+    // the slots before writes_end are written, the rest are read
+    bool any(uint32_t const *slots, uint32_t const *end, uint32_t const *writes_end) const {
+        for (; slots < end; slots++) {
+            if (conflicts(*slots, slots < writes_end)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void set_all(uint32_t const *slots, uint32_t const *end, uint32_t const *writes_end) {
+        for (; slots < end; slots++) {
+            set(*slots, slots < writes_end);
+        }
+    }
+
+    void reset() {
+        for (auto w: touched) {
+            words[w] = 0;
+        }
+        touched.clear();
+    }
+
+    std::vector<uint64_t> storage;
+    uint64_t *words;
+    std::vector<uint32_t> touched;
+};
+
+/**
+ * A transaction waiting for a cycle with the slots of its accounts inline, so a scan streams through one array instead
+ * of chasing every transaction's account list.  Longer account lists are read from the transaction.
+ */
+struct Pending {
+    static const uint INLINE_SLOTS = 5;
+
+    Transaction const *transaction;
+    uint16_t count;
+    uint16_t write_count;
+    uint32_t slots[INLINE_SLOTS];
+
+    explicit Pending(Transaction const *t)
+        : transaction(t)
+        , count(std::min<std::size_t>(t->accounts.size(), UINT16_MAX))
+        , write_count(std::min<uint>(t->write_count, UINT16_MAX))
+        , slots()
+    {
+        for (uint i = 0; i < count && i < INLINE_SLOTS; i++) {
+            slots[i] = t->accounts[i].as_numeric() & (TRACKED_ACCOUNTS - 1);
+        }
+    }
+
+    // counts are clamped so anything that does not fit inline is read from the transaction
+    bool is_inline() const {
+        return count <= INLINE_SLOTS;
+    }
+};
+
+static_assert(sizeof(Pending) == 32, "unexpected size of struct Pending");
+
+typedef std::vector<Pending> Pending_list;
+typedef std::vector<Transaction const *> Transaction_list;
+typedef void (*Scan_fn)(Pending_list const &current, Account_bitset &used, Transaction_list &accepted, Pending_list &postponed);
+
+static bool any_used(Pending const &p, Account_bitset const &used) {
+    if (p.is_inline()) {
+        return used.any(p.slots, p.slots + p.count, p.slots + p.write_count);
+    }
+
+    auto const &t = *p.transaction;
+    for (uint i = 0; i < t.accounts.size(); i++) {
+        if (used.conflicts(t.accounts[i].as_numeric() & (TRACKED_ACCOUNTS - 1), t.writes_account(i))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void set_used(Pending const &p, Account_bitset &used) {
+    if (p.is_inline()) {
+        used.set_all(p.slots, p.slots + p.count, p.slots + p.write_count);
+        return;
+    }
+
+    auto const &t = *p.transaction;
+    for (uint i = 0; i < t.accounts.size(); i++) {
+        used.set(t.accounts[i].as_numeric() & (TRACKED_ACCOUNTS - 1), t.writes_account(i));
+    }
+}
+
+void scan_scalar(Pending_list const &current, Account_bitset &used, Transaction_list &accepted, Pending_list &postponed) {
+    for (auto const &p: current) {
+        if (any_used(p, used)) {
+            postponed.push_back(p);
+        } else {
+            set_used(p, used);
+            accepted.push_back(p.transaction);
+        }
+    }
+}
+
+#ifdef DELAY_CONFLICTS_HAS_AVX2
+
+// test the first 4 inline slots with one gather, lanes past count are masked off and write lanes also test the read bit
+__attribute__((target("avx2")))
+inline bool any_used_avx2(Pending const &p, Account_bitset const &used) {
+    static const uint LANES = 4;
+    __m128i lanes = _mm_loadu_si128(reinterpret_cast<__m128i const *>(p.slots));
+    __m128i lane_index = _mm_setr_epi32(0, 1, 2, 3);
+    __m128i active = _mm_cmpgt_epi32(_mm_set1_epi32(p.count), lane_index);
+    __m128i writes = _mm_cmpgt_epi32(_mm_set1_epi32(p.write_count), lane_index);
+    __m128i conflict_bits = _mm_or_si128(_mm_set1_epi32(WRITTEN_BIT), _mm_and_si128(writes, _mm_set1_epi32(READ_BIT)));
+    __m128i shifts = _mm_slli_epi32(_mm_and_si128(lanes, _mm_set1_epi32(SLOTS_PER_WORD - 1)), 1);
+    __m256i gathered = _mm256_mask_i32gather_epi64(_mm256_setzero_si256(), reinterpret_cast<long long const *>(used.words), _mm_srli_epi32(lanes, 5), _mm256_cvtepi32_epi64(active), 8);
+    __m256i masks = _mm256_sllv_epi64(_mm256_cvtepu32_epi64(conflict_bits), _mm256_cvtepu32_epi64(shifts));
+    if (!_mm256_testz_si256(gathered, masks)) {
+        return true;
+    }
+
+    if (p.count <= LANES) {
+        return false;
+    }
+
+    if (p.is_inline()) {
+        return used.any(p.slots + LANES, p.slots + p.count, p.slots + p.write_count);
+    }
+
+    return any_used(p, used);
+}
+
+__attribute__((target("avx2")))
+void scan_avx2(Pending_list const &current, Account_bitset &used, Transaction_list &accepted, Pending_list &postponed) {
+    for (auto const &p: current) {
+        if (any_used_avx2(p, used)) {
+            postponed.push_back(p);
+        } else {
+            set_used(p, used);
+            accepted.push_back(p.transaction);
+        }
+    }
+}
+
+Scan_fn select_scan() {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") ? scan_avx2 : scan_scalar;
+}
+
+#else
+
+Scan_fn select_scan() {
+    return scan_scalar;
+}
+
+#endif
+
+}
+
+Standard_Block delay_conflicts_bitset(std::vector<Transaction> const &transactions) {
+    static Scan_fn const scan = select_scan();
+    std::vector<Standard_Block::Entry> schedule;
+    schedule.reserve(transactions.size());
+
+    Pending_list current;
+    {
+        SCOPE_PROFILE("Init Current");
+        current.reserve(transactions.size());
+        for (auto const &t: transactions) {
+            current.emplace_back(&t);
+        }
+    }
+
+    Pending_list postponed;
+    Transaction_list accepted;
+    postponed.reserve(transactions.size());
+    accepted.reserve(transactions.size());
+
+    Account_bitset used;
+    uint cycle = 0;
+    while (!current.empty()) {
+        SCOPE_PROFILE("Process Cycle:", cycle);
+        {
+            SCOPE_PROFILE("Scan for Transactions");
+            scan(current, used, accepted, postponed);
+        }
+
+        // no progress means the remaining transactions can never be scheduled, delay_conflicts stops here too
+        if (accepted.empty()) {
+            break;
+        }
+
+        uint thread = 0;
+        for (auto t: accepted) {
+            schedule.emplace_back(cycle, thread++, t->id);
+        }
+
+        {
+            SCOPE_PROFILE("Reset Tracking");
+            accepted.clear();
+            current.clear();
+            used.reset();
+            std::swap(current, postponed);
+            ++cycle;
+        }
+    }
+
+    return Standard_Block(schedule);
+}
+
+}}
@@ -1,7 +1,13 @@
+#include <algorithm>
+#include <functional>
 #include <iostream>
+#include <queue>
 #include <set>
+#include "algorithms/access_tracker.hpp"
 #include "algorithms/graph.hpp"
-#include <boost/optional.hpp>
+#include "algorithms/csr_graph.hpp"
+#include "util/output.hpp"
+#include "util/parallel.hpp"
 #include "util/scope_profile.hpp"
 
 
@@ -17,11 +23,66 @@ struct Account_tracker {
     }
 
     std::set<Transaction::Id> transactions;
-    boost::optional<Transaction::Id> previous;
+    Access_tracker<Transaction const> previous;
 };
 
+// collects roots and links into a Graph
+struct Graph_emitter {
+    Graph &graph;
 
-Graph graph_by_account_degree(std::vector<Transaction> const &transactions)
+    void root(Transaction const &t) {
+        graph.roots.emplace_back(t.id);
+    }
+
+    void link(Transaction const &from, Transaction const &to) {
+        graph.links.emplace(from.id, to.id);
+    }
+};
+
+// collects roots and links into a Csr_graph using the position of each transaction in the input as its node
+struct Csr_emitter {
+    Csr_graph::Builder &builder;
+    Transaction const *base;
+
+    void root(Transaction const &t) {
+        builder.add_root(&t - base);
+    }
+
+    void link(Transaction const &from, Transaction const &to) {
+        builder.add_link(&from - base, &to - base);
+    }
+};
+
+const uint Csr_graph::NO_NODE;
+
+Csr_graph to_csr_graph(Graph const &graph) {
+    SCOPE_PROFILE("Convert Graph to CSR");
+    // graphs do not list their nodes, every node is either a root or the target of a link
+    std::vector<Transaction::Id> ids(graph.roots.begin(), graph.roots.end());
+    for (auto const &l: graph.links) {
+        ids.emplace_back(l.second);
+    }
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+
+    Csr_graph::Builder builder(std::move(ids));
+    auto index_of = [&builder](Transaction::Id const &id) -> uint {
+        return std::lower_bound(builder.ids.begin(), builder.ids.end(), id) - builder.ids.begin();
+    };
+
+    for (auto const &r: graph.roots) {
+        builder.add_root(index_of(r));
+    }
+
+    for (auto const &l: graph.links) {
+        builder.add_link(index_of(l.first), index_of(l.second));
+    }
+
+    return builder.build();
+}
+
+template<typename EMITTER>
+static void account_degree_links(std::vector<Transaction> const &transactions, EMITTER &result)
 {
     auto init_maps = [](std::vector<Transaction> const &transactions){
         SCOPE_PROFILE("Map Transactions By ID");
@@ -68,9 +129,7 @@ Graph graph_by_account_degree(std::vector<Transaction> const &transactions)
 
     auto accounts_by_degree = init_account_degrees(account_trackers);
 
-    std::cout << "Highest Degree: " << (*accounts_by_degree.rbegin()).first << std::endl;
-
-    Graph result;
+    util::output() << "Highest Degree: " << (*accounts_by_degree.rbegin()).first << std::endl;
 
     // iteratively calculate the graph
     while (!account_trackers.empty()) {
@@ -82,7 +141,8 @@ Graph graph_by_account_degree(std::vector<Transaction> const &transactions)
 
         // link the node to any "previous" transactions on all the accounts it references
         int num_previous = 0;
-        for(auto const ref_a_id: selected_transaction.accounts) {
+        for (uint ref_index = 0; ref_index < selected_transaction.accounts.size(); ref_index++) {
+            auto const ref_a_id = selected_transaction.accounts[ref_index];
             auto &ref_tracker = account_trackers[ref_a_id];
 
             // remove this tracker from its current degree bucket
@@ -95,12 +155,10 @@ Graph graph_by_account_degree(std::vector<Transaction> const &transactions)
 
             // remove this transaction and store it as "previous" for all of the accounts it references
             ref_tracker.transactions.erase(selected_transaction.id);
-            if (ref_tracker.previous) {
-                result.links.emplace(*ref_tracker.previous, selected_transaction.id);
+            ref_tracker.previous.access(selected_transaction, selected_transaction.writes_account(ref_index), [&](Transaction const &previous) {
+                result.link(previous, selected_transaction);
                 num_previous++;
-            }
-
-            ref_tracker.previous = selected_transaction.id;
+            });
 
             // if this account has no more transactions, remove its tracker
             if (ref_tracker.transactions.size() == 0) {
@@ -118,14 +176,150 @@ Graph graph_by_account_degree(std::vector<Transaction> const &transactions)
 
         // if none of the referenced accounts have a previous transaction, this node is a root
         if (num_previous == 0) {
-            result.roots.emplace_back(selected_transaction.id);
+            result.root(selected_transaction);
         }
 
         // loop until there are no more accounts.
     }
+}
 
+Graph graph_by_account_degree(std::vector<Transaction> const &transactions) {
+    Graph result;
+    Graph_emitter emitter {result};
+    account_degree_links(transactions, emitter);
     return result;
-   
+}
+
+Csr_graph csr_graph_by_account_degree(std::vector<Transaction> const &transactions) {
+    Csr_graph::Builder builder(transactions);
+    Csr_emitter emitter {builder, transactions.data()};
+    account_degree_links(transactions, emitter);
+    return builder.build();
+}
+
+/**
+ * Same selection policy as account_degree_links: the lowest transaction id still unscheduled in the lowest account id
+ * of the highest degree.  Degrees only ever decrease, so a bucket queue whose max pointer only moves down replaces the
+ * degree map, and each bucket is a min-heap of account ids where an entry is stale once the account's degree changes.
+ */
+template<typename EMITTER>
+static void account_degree_bucket_links(std::vector<Transaction> const &transactions, EMITTER &result)
+{
+    struct Account_list {
+        std::vector<Transaction const *> transactions;
+        uint cursor = 0;
+        uint degree = 0;
+        Access_tracker<Transaction const> previous;
+    };
+
+    typedef std::priority_queue<uint, std::vector<uint>, std::greater<uint>> Bucket;
+
+    std::vector<Account_list> accounts;
+    std::vector<uint8_t> scheduled(transactions.size(), 0);
+    {
+        SCOPE_PROFILE("Map Transactions By Account");
+        uint max_account = 0;
+        for (auto const &t: transactions) {
+            for (auto const &a_id: t.accounts) {
+                max_account = std::max(max_account, a_id.as_numeric() + 1);
+            }
+        }
+
+        accounts.resize(max_account);
+        for (auto const &t: transactions) {
+            for (auto const &a_id: t.accounts) {
+                accounts[a_id.as_numeric()].transactions.push_back(&t);
+            }
+        }
+
+        auto by_id = [](Transaction const *a, Transaction const *b) {
+            return a->id < b->id;
+        };
+
+        for (auto &a: accounts) {
+            if (!std::is_sorted(a.transactions.begin(), a.transactions.end(), by_id)) {
+                std::sort(a.transactions.begin(), a.transactions.end(), by_id);
+            }
+            a.degree = a.transactions.size();
+        }
+    }
+
+    uint max_degree = 0;
+    std::vector<Bucket> buckets;
+    {
+        SCOPE_PROFILE("Calculate Account Degrees");
+        for (auto const &a: accounts) {
+            max_degree = std::max(max_degree, a.degree);
+        }
+
+        buckets.resize(max_degree + 1);
+        for (uint a = 0; a < accounts.size(); a++) {
+            if (accounts[a].degree > 0) {
+                buckets[accounts[a].degree].push(a);
+            }
+        }
+    }
+
+    if (max_degree == 0) {
+        return;
+    }
+
+    util::output() << "Highest Degree: " << max_degree << std::endl;
+
+    while (true) {
+        // drop stale entries and empty buckets until the top of the highest bucket is current
+        while (max_degree > 0 && (buckets[max_degree].empty() || accounts[buckets[max_degree].top()].degree != max_degree)) {
+            if (buckets[max_degree].empty()) {
+                max_degree--;
+            } else {
+                buckets[max_degree].pop();
+            }
+        }
+
+        if (max_degree == 0) {
+            break;
+        }
+
+        auto &selected_account = accounts[buckets[max_degree].top()];
+        while (scheduled[selected_account.transactions[selected_account.cursor] - transactions.data()]) {
+            selected_account.cursor++;
+        }
+
+        auto &selected_transaction = *selected_account.transactions[selected_account.cursor];
+        scheduled[&selected_transaction - transactions.data()] = 1;
+
+        int num_previous = 0;
+        for (uint ref_index = 0; ref_index < selected_transaction.accounts.size(); ref_index++) {
+            auto const ref_a_id = selected_transaction.accounts[ref_index];
+            auto &ref_account = accounts[ref_a_id.as_numeric()];
+            ref_account.previous.access(selected_transaction, selected_transaction.writes_account(ref_index), [&](Transaction const &previous) {
+                result.link(previous, selected_transaction);
+                num_previous++;
+            });
+
+            if (--ref_account.degree > 0) {
+                buckets[ref_account.degree].push(ref_a_id.as_numeric());
+            }
+        }
+
+        if (num_previous == 0) {
+            result.root(selected_transaction);
+        }
+    }
+}
+
+Graph graph_by_account_degree_bucket(std::vector<Transaction> const &transactions) {
+    Graph result;
+    Graph_emitter emitter {result};
+    account_degree_bucket_links(transactions, emitter);
+    return result;
+}
+
+Csr_graph csr_graph_by_account_degree_bucket(std::vector<Transaction> const &transactions) {
+    Csr_graph::Builder builder(transactions);
+    Csr_emitter emitter {builder, transactions.data()};
+    account_degree_bucket_links(transactions, emitter);
+    return builder.build();
 }
 
 uint next_power_of_two(uint input) {
@@ -145,49 +339,249 @@ uint next_power_of_two(uint input) {
 }
 
 
-Graph graph_by_hash_conflict(std::vector<Transaction> const &transactions) {
+template<typename EMITTER>
+static void hash_conflict_links(std::vector<Transaction> const &transactions, EMITTER &result) {
     static std::hash<Account::Id::storage_type> hasher;
     
     uint HASH_SIZE = std::max<uint>(4096, next_power_of_two(transactions.size() / 8));
-    std::vector<Transaction const *> prev_hash(HASH_SIZE);
-    Graph result;
-    result.roots.reserve(transactions.size());
+    std::vector<Access_tracker<Transaction const>> prev_hash(HASH_SIZE);
 
-    std::vector<Transaction::Id> previous;
+    std::vector<Transaction const *> previous;
     previous.reserve(64);
+    auto add_previous = [&previous](Transaction const &p) {
+        previous.emplace_back(&p);
+    };
 
     for (auto const &t: transactions) {
-        for (auto const &a : t.accounts ) {
-            uint hash_index = hasher(a.as_numeric()) % HASH_SIZE;
-
-            auto &prev = prev_hash.at(hash_index);
-            if (prev != nullptr && prev != &t) {
-                previous.emplace_back(prev->id);
-            }
-            prev = &t;
+        for (uint a = 0; a < t.accounts.size(); a++) {
+            uint hash_index = hasher(t.accounts[a].as_numeric()) % HASH_SIZE;
+            prev_hash.at(hash_index).access(t, t.writes_account(a), add_previous);
         }
 
         if (previous.size() == 0) {
             // list this transaction as a root
-            result.roots.emplace_back(t.id);
+            result.root(t);
         } else {
-            // list the de-duplicated previous transaction IDs as links
-            std::sort(previous.begin(), previous.end());
-            boost::optional<Transaction::Id> dupe_check;
+            // list the de-duplicated previous transactions as links
+            std::sort(previous.begin(), previous.end(), [](Transaction const *l, Transaction const *r) {
+                return l->id < r->id;
+            });
+            auto unique_end = std::unique(previous.begin(), previous.end());
             
-            for (auto const &p_id: previous) {
-                if (!dupe_check || p_id != *dupe_check) {
-                    result.links.emplace(p_id, t.id);
-                }
-
-                dupe_check = boost::make_optional(p_id);
+            for (auto iter = previous.begin(); iter != unique_end; ++iter) {
+                result.link(**iter, t);
             }
             previous.clear();
         }
     }
+}
+
+Graph graph_by_hash_conflict(std::vector<Transaction> const &transactions) {
+    Graph result;
+    result.roots.reserve(transactions.size());
+    Graph_emitter emitter {result};
+    hash_conflict_links(transactions, emitter);
+    return result;
+}
+
+Csr_graph csr_graph_by_hash_conflict(std::vector<Transaction> const &transactions) {
+    Csr_graph::Builder builder(transactions);
+    Csr_emitter emitter {builder, transactions.data()};
+    hash_conflict_links(transactions, emitter);
+    return builder.build();
+}
+
+struct Hash_conflict_chunk {
+    uint begin;
+    uint end;
+
+    // in-chunk previous transaction indices, by local transaction index
+    std::vector<uint> previous_offsets;
+    std::vector<uint> previous;
+
+    // an access whose previous accesses may be in earlier chunks: every read before the first in-chunk write to its slot
+    // and that first write
+    struct Boundary {
+        uint local;
+        uint slot;
+        bool write;
+        bool after_local_readers;
+    };
+    std::vector<Boundary> boundary;
+    std::vector<uint> boundary_previous_offsets;
+    std::vector<Transaction const *> boundary_previous;
+
+    // (hash slot, accesses since the chunk began) for every slot this chunk touched, sorted by slot
+    std::vector<std::pair<uint, Access_tracker<Transaction const>>> last_by_slot;
+
+    // (previous id, transaction id) in input order of the transaction
+    std::vector<std::pair<Transaction::Id, Transaction::Id>> links;
+    std::vector<Transaction::Id> roots;
+};
+
+Graph graph_by_hash_conflict_parallel(std::vector<Transaction> const &transactions, uint thread_count) {
+    static std::hash<Account::Id::storage_type> hasher;
+
+    uint HASH_SIZE = std::max<uint>(4096, next_power_of_two(transactions.size() / 8));
+    uint const num_transactions = transactions.size();
+    uint const num_chunks = std::max(1u, std::min(thread_count, num_transactions));
+    uint const chunk_size = (num_transactions + num_chunks - 1) / std::max(1u, num_chunks);
+
+    std::vector<Hash_conflict_chunk> chunks(num_chunks);
+    for (uint c = 0; c < num_chunks; c++) {
+        chunks[c].begin = std::min(num_transactions, c * chunk_size);
+        chunks[c].end = std::min(num_transactions, (c + 1) * chunk_size);
+    }
+
+    // build per-chunk access tables and in-chunk links
+    util::parallel_for(num_chunks, thread_count, [&](uint c) {
+        SCOPE_PROFILE("Scan Chunk", c);
+        auto &chunk = chunks[c];
+        std::vector<Access_tracker<Transaction const>> last(HASH_SIZE);
+        std::vector<uint> touched;
+        auto add_previous = [&](Transaction const &p) {
+            chunk.previous.emplace_back(&p - transactions.data());
+        };
+
+        chunk.previous_offsets.reserve(chunk.end - chunk.begin + 1);
+        for (uint index = chunk.begin; index < chunk.end; index++) {
+            auto const &t = transactions[index];
+            chunk.previous_offsets.emplace_back(chunk.previous.size());
+            for (uint a = 0; a < t.accounts.size(); a++) {
+                uint hash_index = hasher(t.accounts[a].as_numeric()) % HASH_SIZE;
+                bool write = t.writes_account(a);
+
+                auto &tracker = last[hash_index];
+                if (tracker.writer == nullptr) {
+                    if (tracker.readers.empty()) {
+                        touched.emplace_back(hash_index);
+                    }
+                    bool after_local_readers = std::any_of(tracker.readers.begin(), tracker.readers.end(), [&t](Transaction const *r) {
+                        return r != &t;
+                    });
+                    chunk.boundary.push_back(Hash_conflict_chunk::Boundary {index - chunk.begin, hash_index, write, after_local_readers});
+                }
+                tracker.access(t, write, add_previous);
+            }
+        }
+        chunk.previous_offsets.emplace_back(chunk.previous.size());
+
+        std::sort(touched.begin(), touched.end());
+        chunk.last_by_slot.reserve(touched.size());
+        for (auto const &slot: touched) {
+            chunk.last_by_slot.emplace_back(slot, std::move(last[slot]));
+        }
+    });
+
+    // stitch chunk boundaries: walk back through earlier chunks until one wrote the slot, collecting the readers since
+    util::parallel_for(num_chunks, thread_count, [&](uint c) {
+        SCOPE_PROFILE("Stitch Chunk", c);
+        auto &chunk = chunks[c];
+        std::vector<Transaction const *> readers;
+        chunk.boundary_previous_offsets.reserve(chunk.boundary.size() + 1);
+        for (auto const &b: chunk.boundary) {
+            chunk.boundary_previous_offsets.emplace_back(chunk.boundary_previous.size());
+            Transaction const *writer = nullptr;
+            readers.clear();
+            for (uint p = c; p > 0 && writer == nullptr; p--) {
+                auto const &slots = chunks[p - 1].last_by_slot;
+                auto iter = std::lower_bound(slots.begin(), slots.end(), b.slot, [](std::pair<uint, Access_tracker<Transaction const>> const &l, uint slot) {
+                    return l.first < slot;
+                });
+                if (iter != slots.end() && iter->first == b.slot) {
+                    if (b.write) {
+                        readers.insert(readers.end(), iter->second.readers.begin(), iter->second.readers.end());
+                    }
+                    writer = iter->second.writer;
+                }
+            }
+
+            if (b.write && !readers.empty()) {
+                chunk.boundary_previous.insert(chunk.boundary_previous.end(), readers.begin(), readers.end());
+            } else if (writer != nullptr && !(b.write && b.after_local_readers)) {
+                chunk.boundary_previous.emplace_back(writer);
+            }
+        }
+        chunk.boundary_previous_offsets.emplace_back(chunk.boundary_previous.size());
+    });
+
+    // emit de-duplicated links and roots per chunk
+    util::parallel_for(num_chunks, thread_count, [&](uint c) {
+        SCOPE_PROFILE("Link Chunk", c);
+        auto &chunk = chunks[c];
+        std::vector<Transaction::Id> previous;
+        previous.reserve(64);
+
+        uint boundary_index = 0;
+        for (uint index = chunk.begin; index < chunk.end; index++) {
+            uint local = index - chunk.begin;
+            for (uint p = chunk.previous_offsets[local]; p < chunk.previous_offsets[local + 1]; p++) {
+                previous.emplace_back(transactions[chunk.previous[p]].id);
+            }
+
+            for (; boundary_index < chunk.boundary.size() && chunk.boundary[boundary_index].local == local; boundary_index++) {
+                for (uint p = chunk.boundary_previous_offsets[boundary_index]; p < chunk.boundary_previous_offsets[boundary_index + 1]; p++) {
+                    previous.emplace_back(chunk.boundary_previous[p]->id);
+                }
+            }
 
+            auto const &t = transactions[index];
+            if (previous.size() == 0) {
+                chunk.roots.emplace_back(t.id);
+            } else {
+                std::sort(previous.begin(), previous.end());
+                auto unique_end = std::unique(previous.begin(), previous.end());
+                for (auto iter = previous.begin(); iter != unique_end; ++iter) {
+                    chunk.links.emplace_back(*iter, t.id);
+                }
+                previous.clear();
+            }
+        }
+
+        std::stable_sort(chunk.links.begin(), chunk.links.end(), [](auto const &l, auto const &r) {
+            return l.first < r.first;
+        });
+    });
+
+    Graph result;
+    {
+        SCOPE_PROFILE("Merge Chunks");
+        result.roots.reserve(num_transactions);
+        for (auto const &chunk: chunks) {
+            result.roots.insert(result.roots.end(), chunk.roots.begin(), chunk.roots.end());
+        }
+
+        // k-way merge of the sorted chunk links, ties resolve to the earlier chunk so that links from the same
+        // transaction keep the order the sequential version inserts them in
+        typedef std::pair<Transaction::Id, uint> Merge_head;
+        auto head_after = [](Merge_head const &l, Merge_head const &r) {
+            return r.first < l.first || (!(l.first < r.first) && r.second < l.second);
+        };
+        std::priority_queue<Merge_head, std::vector<Merge_head>, decltype(head_after)> heads(head_after);
+        std::vector<uint> positions(num_chunks, 0);
+        for (uint c = 0; c < num_chunks; c++) {
+            if (!chunks[c].links.empty()) {
+                heads.emplace(chunks[c].links.front().first, c);
+            }
+        }
+
+        while (!heads.empty()) {
+            uint c = heads.top().second;
+            heads.pop();
+            auto const &links = chunks[c].links;
+            auto &pos = positions[c];
+            auto const from = links[pos].first;
+            for (; pos < links.size() && links[pos].first == from; pos++) {
+                result.links.emplace_hint(result.links.end(), links[pos]);
+            }
+
+            if (pos < links.size()) {
+                heads.emplace(links[pos].first, c);
+            }
+        }
+    }
 
     return result;
 }
 
-}}
\ No newline at end of file
+}}
@@ -0,0 +1,152 @@
+#include <algorithm>
+#include <limits>
+#include "algorithms/list_schedule.hpp"
+#include "util/scope_profile.hpp"
+
+namespace sched_bench { namespace algorithms {
+
+namespace {
+
+static const uint NONE = std::numeric_limits<uint>::max();
+
+// cycles searched past the earliest allowed one before falling back to a new cycle, this bounds the work per transaction
+static const uint LOOKAHEAD_CYCLES = 64;
+
+struct Cycle {
+    explicit Cycle(uint thread_count)
+        : load(thread_count, 0.0)
+        , max_load(0.0)
+        , min_thread(0)
+    {
+    }
+
+    void add(uint thread, double cost) {
+        load[thread] += cost;
+        max_load = std::max(max_load, load[thread]);
+        if (thread == min_thread) {
+            min_thread = std::min_element(load.begin(), load.end()) - load.begin();
+        }
+    }
+
+    std::vector<double> load;
+    double max_load;
+    uint min_thread;
+};
+
+/**
+ * Where an account was last written and, since then, the latest cycle it was read in.  An access is pinned to a thread
+ * when everything it conflicts with in that cycle ran on the same thread, MIXED when it spans several.
+ */
+struct Account_state {
+    static const uint MIXED = NONE - 1;
+
+    uint write_cycle = NONE;
+    uint write_thread = NONE;
+    uint read_cycle = NONE;
+    uint read_thread = NONE;
+};
+
+// the latest conflicting cycle and the only thread that may join it, NONE for the cycle when there are no conflicts
+struct Constraint {
+    uint cycle = NONE;
+    uint thread = NONE;
+
+    void add(uint c, uint t) {
+        if (c == NONE) {
+            return;
+        }
+
+        if (cycle == NONE || c > cycle) {
+            cycle = c;
+            thread = t;
+        } else if (c == cycle && t != thread) {
+            thread = Account_state::MIXED;
+        }
+    }
+};
+
+}
+
+Standard_Block list_schedule_by_cost(std::vector<Transaction> const &transactions, util::Array_view<double> costs, uint thread_count) {
+    thread_count = std::max(1u, thread_count);
+    std::vector<Standard_Block::Entry> schedule;
+    schedule.reserve(transactions.size());
+
+    std::vector<Account_state> accounts;
+    {
+        SCOPE_PROFILE("Init Accounts");
+        uint max_account = 0;
+        for (auto const &t: transactions) {
+            for (auto const &a_id: t.accounts) {
+                max_account = std::max(max_account, a_id.as_numeric() + 1);
+            }
+        }
+        accounts.resize(max_account);
+    }
+
+    std::vector<Cycle> cycles;
+    {
+        SCOPE_PROFILE("Place Transactions");
+        for (auto const &t: transactions) {
+            Constraint constraint;
+            for (uint a = 0; a < t.accounts.size(); a++) {
+                auto const &state = accounts[t.accounts[a].as_numeric()];
+                constraint.add(state.write_cycle, state.write_thread);
+                if (t.writes_account(a)) {
+                    constraint.add(state.read_cycle, state.read_thread);
+                }
+            }
+
+            // the cheapest growth of the makespan, ties go to the earliest cycle
+            double cost = costs[t.id.as_numeric()];
+            uint best_cycle = cycles.size();
+            uint best_thread = 0;
+            double best_growth = cost;
+            uint first = constraint.cycle == NONE ? 0 : constraint.cycle;
+            uint last = std::min<std::size_t>(cycles.size(), first + LOOKAHEAD_CYCLES);
+            for (uint c = first; c < last && best_growth > 0.0; c++) {
+                auto const &cycle = cycles[c];
+                uint thread = cycle.min_thread;
+                if (c == constraint.cycle) {
+                    // only the thread already running the conflicting transactions can take this one after them
+                    if (constraint.thread == Account_state::MIXED) {
+                        continue;
+                    }
+                    thread = constraint.thread;
+                }
+
+                double growth = std::max(0.0, cycle.load[thread] + cost - cycle.max_load);
+                if (growth < best_growth) {
+                    best_growth = growth;
+                    best_cycle = c;
+                    best_thread = thread;
+                }
+            }
+
+            if (best_cycle == cycles.size()) {
+                cycles.emplace_back(thread_count);
+            }
+            cycles[best_cycle].add(best_thread, cost);
+            schedule.emplace_back(best_cycle, best_thread, t.id);
+
+            for (uint a = 0; a < t.accounts.size(); a++) {
+                auto &state = accounts[t.accounts[a].as_numeric()];
+                if (t.writes_account(a)) {
+                    state.write_cycle = best_cycle;
+                    state.write_thread = best_thread;
+                    state.read_cycle = NONE;
+                    state.read_thread = NONE;
+                } else if (state.read_cycle == NONE || best_cycle > state.read_cycle) {
+                    state.read_cycle = best_cycle;
+                    state.read_thread = best_thread;
+                } else if (best_cycle == state.read_cycle && best_thread != state.read_thread) {
+                    state.read_thread = Account_state::MIXED;
+                }
+            }
+        }
+    }
+
+    return Standard_Block(schedule);
+}
+
+}}
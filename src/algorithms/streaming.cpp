@@ -0,0 +1,181 @@
+#include <algorithm>
+#include <functional>
+#include "algorithms/streaming.hpp"
+#include "util/scope_profile.hpp"
+
+namespace sched_bench { namespace algorithms {
+using namespace sched_bench::model;
+
+static uint hash_table_size(uint expected_transactions) {
+    uint size = 4096;
+    while (size < expected_transactions / 8) {
+        size *= 2;
+    }
+    return size;
+}
+
+Streaming_hash_conflict::Streaming_hash_conflict(uint expected_transactions)
+    : hash_size(hash_table_size(expected_transactions))
+    , slots(hash_size)
+    , remaining(0)
+{
+    previous.reserve(64);
+}
+
+void Streaming_hash_conflict::push(Transaction const &t) {
+    static std::hash<Account::Id::storage_type> hasher;
+    nodes.push_back(Node {&t, 0, false, {}});
+    auto &node = nodes.back();
+    remaining++;
+
+    // transactions that already completed cannot hold this one up
+    auto add_previous = [this](Node &p) {
+        if (!p.done) {
+            previous.emplace_back(&p);
+        }
+    };
+
+    for (uint a = 0; a < t.accounts.size(); a++) {
+        uint hash_index = hasher(t.accounts[a].as_numeric()) % hash_size;
+        slots[hash_index].access(node, t.writes_account(a), add_previous);
+    }
+
+    std::sort(previous.begin(), previous.end());
+    auto unique_end = std::unique(previous.begin(), previous.end());
+    for (auto iter = previous.begin(); iter != unique_end; ++iter) {
+        (*iter)->dependents.push_back(&node);
+        node.unmet++;
+    }
+    previous.clear();
+
+    if (node.unmet == 0) {
+        ready.push_back(&node);
+    }
+}
+
+// nothing to flush, whoever feeds the scheduler decides when the stream is over
+void Streaming_hash_conflict::close() {
+}
+
+std::vector<Transaction::Id> Streaming_hash_conflict::next() {
+    if (ready.empty()) {
+        return std::vector<Transaction::Id>();
+    }
+
+    auto node = ready.front();
+    ready.pop_front();
+    running.emplace(node->transaction->id.as_numeric(), node);
+    return std::vector<Transaction::Id> {{node->transaction->id}};
+}
+
+void Streaming_hash_conflict::finalize(std::vector<Transaction::Id> const &dispatch) {
+    for (auto const &t_id: dispatch) {
+        auto iter = running.find(t_id.as_numeric());
+        auto node = iter->second;
+        running.erase(iter);
+
+        node->done = true;
+        remaining--;
+        for (auto dependent: node->dependents) {
+            if (--dependent->unmet == 0) {
+                ready.push_back(dependent);
+            }
+        }
+        node->dependents.clear();
+        node->dependents.shrink_to_fit();
+    }
+}
+
+bool Streaming_hash_conflict::empty() const {
+    return remaining == 0;
+}
+
+// accounts are tracked modulo this many slots, exactly as delay_conflicts does
+static const uint TRACKED_ACCOUNTS = 1024 * 1024;
+static const uint8_t WRITTEN = 1;
+static const uint8_t READ = 2;
+
+Streaming_delay_conflicts::Streaming_delay_conflicts()
+    : used(TRACKED_ACCOUNTS, 0)
+    , outstanding(0)
+    , remaining(0)
+    , cycle(0)
+{
+}
+
+bool Streaming_delay_conflicts::try_accept(Transaction const &t) {
+    for (uint a = 0; a < t.accounts.size(); a++) {
+        auto slot = used[t.accounts[a].as_numeric() % TRACKED_ACCOUNTS];
+        if (slot & (t.writes_account(a) ? WRITTEN | READ : WRITTEN)) {
+            return false;
+        }
+    }
+
+    for (uint a = 0; a < t.accounts.size(); a++) {
+        uint index = t.accounts[a].as_numeric() % TRACKED_ACCOUNTS;
+        if (used[index] == 0) {
+            touched.push_back(index);
+        }
+        used[index] |= t.writes_account(a) ? WRITTEN : READ;
+    }
+
+    ready.push_back(&t);
+    return true;
+}
+
+void Streaming_delay_conflicts::start_cycle() {
+    SCOPE_PROFILE("Start Cycle", cycle + 1);
+    for (auto index: touched) {
+        used[index] = 0;
+    }
+    touched.clear();
+    cycle++;
+
+    // the waiting transactions keep their arrival order, whatever conflicts waits for the cycle after
+    uint count = waiting.size();
+    for (uint i = 0; i < count; i++) {
+        auto t = waiting.front();
+        waiting.pop_front();
+        if (!try_accept(*t)) {
+            waiting.push_back(t);
+        }
+    }
+}
+
+void Streaming_delay_conflicts::push(Transaction const &t) {
+    remaining++;
+    if (!try_accept(t)) {
+        waiting.push_back(&t);
+    }
+}
+
+// nothing to flush, whoever feeds the scheduler decides when the stream is over
+void Streaming_delay_conflicts::close() {
+}
+
+std::vector<Transaction::Id> Streaming_delay_conflicts::next() {
+    if (ready.empty()) {
+        return std::vector<Transaction::Id>();
+    }
+
+    auto t = ready.front();
+    ready.pop_front();
+    outstanding++;
+    return std::vector<Transaction::Id> {{t->id}};
+}
+
+void Streaming_delay_conflicts::finalize(std::vector<Transaction::Id> const &dispatch) {
+    outstanding -= dispatch.size();
+    remaining -= dispatch.size();
+
+    // the cycle is over once everything accepted into it has completed
+    if (outstanding == 0 && ready.empty()) {
+        start_cycle();
+    }
+}
+
+bool Streaming_delay_conflicts::empty() const {
+    return remaining == 0;
+}
+
+}}
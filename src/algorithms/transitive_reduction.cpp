@@ -0,0 +1,154 @@
+#include <algorithm>
+#include <iostream>
+#include <boost/format.hpp>
+#include "algorithms/graph.hpp"
+#include "algorithms/csr_graph.hpp"
+#include "util/output.hpp"
+#include "util/scope_profile.hpp"
+
+namespace sched_bench { namespace algorithms {
+
+namespace {
+
+// Kahn's algorithm, nodes on a cycle never become ready and are left out
+std::vector<uint> topological_order(Csr_graph const &graph) {
+    SCOPE_PROFILE("Topological Order");
+    std::vector<uint> unmet(graph.node_count(), 0);
+    for (auto const &target: graph.targets) {
+        unmet[target]++;
+    }
+
+    std::vector<uint> order;
+    order.reserve(graph.node_count());
+    for (uint node = 0; node < graph.node_count(); node++) {
+        if (unmet[node] == 0) {
+            order.push_back(node);
+        }
+    }
+
+    for (uint i = 0; i < order.size(); i++) {
+        auto node = order[i];
+        for (uint l = graph.offsets[node]; l < graph.offsets[node + 1]; l++) {
+            if (--unmet[graph.targets[l]] == 0) {
+                order.push_back(graph.targets[l]);
+            }
+        }
+    }
+
+    return order;
+}
+
+}
+
+Csr_graph transitive_reduction(Csr_graph const &graph, uint max_visits) {
+    SCOPE_PROFILE("Transitive Reduction");
+    auto const order = topological_order(graph);
+    std::vector<uint> position(graph.node_count(), Csr_graph::NO_NODE);
+    for (uint i = 0; i < order.size(); i++) {
+        position[order[i]] = i;
+    }
+
+    // the parents of every node in CSR form, this is where the reduced links are kept
+    std::vector<uint> parent_offsets(graph.node_count() + 1, 0);
+    std::vector<uint> parents(graph.link_count());
+    {
+        SCOPE_PROFILE("Invert Links");
+        for (auto const &target: graph.targets) {
+            parent_offsets[target + 1]++;
+        }
+        for (uint i = 0; i < graph.node_count(); i++) {
+            parent_offsets[i + 1] += parent_offsets[i];
+        }
+
+        std::vector<uint> cursor(parent_offsets.begin(), parent_offsets.end() - 1);
+        for (uint node = 0; node < graph.node_count(); node++) {
+            for (uint l = graph.offsets[node]; l < graph.offsets[node + 1]; l++) {
+                parents[cursor[graph.targets[l]]++] = node;
+            }
+        }
+    }
+
+    // every node keeps its kept parents at the front of its own range, nodes are reduced in topological order so the
+    // searches only ever walk links that are already reduced.  Nodes on a cycle keep all of their links.
+    std::vector<uint> kept_end(parent_offsets.begin() + 1, parent_offsets.end());
+    std::vector<uint> visited(graph.node_count(), Csr_graph::NO_NODE);
+    std::vector<uint> stack;
+    Csr_graph::Builder builder(graph.ids);
+    {
+        SCOPE_PROFILE("Remove Implied Links");
+        for (auto const &r: graph.roots) {
+            builder.add_root(r);
+        }
+
+        auto later_first = [&position](uint l, uint r) {
+            return position[l] > position[r];
+        };
+
+        for (auto node: order) {
+            auto begin = parents.begin() + parent_offsets[node];
+            auto end = parents.begin() + parent_offsets[node + 1];
+            if (end - begin < 2) {
+                continue;
+            }
+
+            std::sort(begin, end, later_first);
+            end = std::unique(begin, end);
+            uint earliest = position[*(end - 1)];
+
+            /**
+             * A parent is implied when it is an ancestor of a later parent that is kept.  The ancestors of the kept
+             * parents are marked with a bounded search that stops short of the earliest parent, a parent that was not
+             * reached is kept even if the search gave up before it could prove the link redundant.
+             */
+            uint visits = 0;
+            auto kept = begin;
+            for (auto p = begin; p != end; ++p) {
+                if (visited[*p] == node) {
+                    continue;
+                }
+
+                *kept++ = *p;
+                stack.assign(1, *p);
+                while (!stack.empty() && visits < max_visits) {
+                    auto ancestor = stack.back();
+                    stack.pop_back();
+                    for (uint l = parent_offsets[ancestor]; l < kept_end[ancestor]; l++) {
+                        auto a = parents[l];
+                        if (visited[a] != node && position[a] >= earliest) {
+                            visited[a] = node;
+                            stack.push_back(a);
+                            visits++;
+                        }
+                    }
+                }
+            }
+
+            kept_end[node] = kept - parents.begin();
+        }
+
+        for (uint node = 0; node < graph.node_count(); node++) {
+            for (uint l = parent_offsets[node]; l < kept_end[node]; l++) {
+                builder.add_link(parents[l], node);
+            }
+        }
+    }
+
+    auto result = builder.build();
+    util::output() << boost::format {"Transitive Reduction: %d links before, %d after\n"} % graph.link_count() % result.link_count();
+    return result;
+}
+
+Graph transitive_reduction(Graph const &graph, uint max_visits) {
+    auto reduced = transitive_reduction(to_csr_graph(graph), max_visits);
+
+    Graph result;
+    result.roots = graph.roots;
+    for (uint node = 0; node < reduced.node_count(); node++) {
+        for (uint l = reduced.offsets[node]; l < reduced.offsets[node + 1]; l++) {
+            result.links.emplace_hint(result.links.end(), reduced.ids[node], reduced.ids[reduced.targets[l]]);
+        }
+    }
+    return result;
+}
+
+}}
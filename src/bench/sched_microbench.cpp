@@ -0,0 +1,214 @@
+#include <iostream>
+#include <map>
+#include <memory>
+#include <utility>
+#include <benchmark/benchmark.h>
+
+#include "runner.hpp"
+#include "algorithms/single_thread.hpp"
+#include "algorithms/delay_conflicts.hpp"
+#include "algorithms/graph.hpp"
+#include "algorithms/csr_graph.hpp"
+#include "algorithms/component_partition.hpp"
+
+/**
+ * Micro-benchmarks of the schedulers and dispatchers on their own, without the simulator around them.  Every benchmark
+ * takes the block size and a contention level as arguments and reports items_per_second, which is transactions per
+ * second.
+ *
+ * The scope profiler is never initialized here, so SCOPE_PROFILE samples are dropped once the thread rings fill.
+ */
+
+using namespace sched_bench;
+
+namespace {
+
+// the average percentage of transactions a scope appears in, from rarely conflicting to heavily contended
+double const CONTENTION_POPULARITY[] = {0.001, 0.01, 0.05};
+char const * const CONTENTION_NAMES[] = {"low", "medium", "high"};
+int const CONTENTION_LEVELS = sizeof(CONTENTION_POPULARITY) / sizeof(CONTENTION_POPULARITY[0]);
+
+Runner::Config microbench_config(uint transaction_count, int contention) {
+    Runner::Config config = Runner::Config();
+    config.transaction_count = transaction_count;
+    config.transaction_cost_ms_mean = 0.3;
+    config.transaction_cost_ms_stddev = 0.25;
+    config.account_popularity_mean = CONTENTION_POPULARITY[contention];
+    config.account_popularity_stddev = CONTENTION_POPULARITY[contention] / 2;
+    config.pct_transactions_per_scope_count = {0.1587, 0.6827, 0.1573, 0.0013};
+    config.seed = 1;
+    config.thread_count = 20;
+    config.host_thread_count = 1;
+    config.repeat = 1;
+    config.arrival_batch = 64;
+    config.trace_format = util::Trace_sink::Format::NONE;
+    return config;
+}
+
+// workloads are generated once per block size and contention level and shared by every benchmark
+Runner::Workload const &workload_for(benchmark::State &state) {
+    static std::map<std::pair<int64_t, int64_t>, std::unique_ptr<Runner::Workload>> workloads;
+    auto key = std::make_pair(state.range(0), state.range(1));
+    auto &workload = workloads[key];
+    if (!workload) {
+        workload.reset(new Runner::Workload(Runner::generate_workload(microbench_config(key.first, key.second))));
+    }
+
+    state.SetLabel(CONTENTION_NAMES[key.second]);
+    return *workload;
+}
+
+// some schedulers print diagnostics to std::cout, which would interleave with the benchmark report
+struct Mute_cout {
+    Mute_cout()
+        : previous(std::cout.rdbuf(nullptr))
+    {
+    }
+
+    ~Mute_cout() {
+        std::cout.rdbuf(previous);
+    }
+
+    std::streambuf *previous;
+};
+
+template<typename SCHED_FN>
+void bench_scheduler(benchmark::State &state, SCHED_FN fn) {
+    auto const &workload = workload_for(state);
+    Mute_cout mute;
+    for (auto _: state) {
+        auto block = fn(workload.transactions);
+        benchmark::DoNotOptimize(block);
+    }
+    state.SetItemsProcessed(state.iterations() * workload.transactions.size());
+}
+
+/**
+ * Drain a block the way the simulator does when every dispatch completes at once: take everything next() offers, then
+ * finalize all of it.  Only the dispatcher is timed, the block is built beforehand.
+ */
+template<typename SCHED_FN>
+void bench_dispatcher(benchmark::State &state, SCHED_FN fn) {
+    auto const &workload = workload_for(state);
+    Mute_cout mute;
+    auto block = fn(workload.transactions);
+    typedef decltype(block) Block;
+
+    std::vector<std::vector<model::Transaction::Id>> running;
+    for (auto _: state) {
+        auto dispatcher = Block::create_dispatcher(block);
+        while (!dispatcher.empty()) {
+            for (auto dispatch = dispatcher.next(); !dispatch.empty(); dispatch = dispatcher.next()) {
+                running.emplace_back(std::move(dispatch));
+            }
+
+            // nothing dispatched while the block is unfinished means the dispatcher is stuck
+            if (running.empty()) {
+                state.SkipWithError("dispatcher stopped before the block was finished");
+                break;
+            }
+
+            for (auto const &dispatch: running) {
+                dispatcher.finalize(dispatch);
+            }
+            running.clear();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * workload.transactions.size());
+}
+
+void BM_single_thread(benchmark::State &state) {
+    bench_scheduler(state, algorithms::single_thread);
+}
+
+void BM_delay_conflicts(benchmark::State &state) {
+    bench_scheduler(state, algorithms::delay_conflicts);
+}
+
+void BM_delay_conflicts_bitset(benchmark::State &state) {
+    bench_scheduler(state, algorithms::delay_conflicts_bitset);
+}
+
+void BM_graph_by_account_degree(benchmark::State &state) {
+    bench_scheduler(state, algorithms::graph_by_account_degree);
+}
+
+void BM_graph_by_hash_conflict(benchmark::State &state) {
+    bench_scheduler(state, algorithms::graph_by_hash_conflict);
+}
+
+void BM_dispatch_single_thread(benchmark::State &state) {
+    bench_dispatcher(state, algorithms::single_thread);
+}
+
+void BM_dispatch_delay_conflicts(benchmark::State &state) {
+    bench_dispatcher(state, algorithms::delay_conflicts_bitset);
+}
+
+void BM_dispatch_graph(benchmark::State &state) {
+    bench_dispatcher(state, algorithms::graph_by_hash_conflict);
+}
+
+void BM_dispatch_csr_graph(benchmark::State &state) {
+    bench_dispatcher(state, algorithms::csr_graph_by_hash_conflict);
+}
+
+/**
+ * At medium and high contention one component costs more than a thread's share of the block and is scheduled like
+ * delay_conflicts.  The block is simulated once beforehand and the benchmark fails if it is estimated to take longer
+ * than delay_conflicts_bitset on its own, the packed components must fit around the oversized one.
+ */
+void BM_component_partition(benchmark::State &state) {
+    auto const &workload = workload_for(state);
+    auto const config = microbench_config(state.range(0), state.range(1));
+    Mute_cout mute;
+
+    auto const partitioned = Runner::execute_one(workload, config, "component_partition", algorithms::partition_by_component);
+    auto const delayed = Runner::execute_one(workload, config, "delay_conflicts_bitset", algorithms::delay_conflicts_bitset);
+    if (!partitioned.valid || partitioned.runtime_est_ms > delayed.runtime_est_ms) {
+        state.SkipWithError("component_partition is estimated to be slower than delay_conflicts_bitset");
+        return;
+    }
+    state.counters["estimated_ms"] = partitioned.runtime_est_ms;
+    state.counters["delay_conflicts_ms"] = delayed.runtime_est_ms;
+
+    for (auto _: state) {
+        auto block = algorithms::partition_by_component(workload.transactions, workload.costs, config.thread_count);
+        benchmark::DoNotOptimize(block);
+    }
+    state.SetItemsProcessed(state.iterations() * workload.transactions.size());
+}
+
+// block size by contention level
+void block_sizes(benchmark::internal::Benchmark *b, int64_t max_block_size) {
+    for (int64_t size = 1000; size <= max_block_size; size *= 10) {
+        for (int contention = 0; contention < CONTENTION_LEVELS; contention++) {
+            b->Args({size, contention});
+        }
+    }
+    b->ArgNames({"block", "contention"})->Unit(benchmark::kMicrosecond);
+}
+
+void small_blocks(benchmark::internal::Benchmark *b) {
+    block_sizes(b, 10000);
+}
+
+void large_blocks(benchmark::internal::Benchmark *b) {
+    block_sizes(b, 100000);
+}
+
+}
+
+BENCHMARK(BM_single_thread)->Apply(large_blocks);
+// these rescan every postponed transaction each cycle or keep ordered maps, the largest blocks would dominate the run
+BENCHMARK(BM_delay_conflicts)->Apply(small_blocks);
+BENCHMARK(BM_delay_conflicts_bitset)->Apply(small_blocks);
+BENCHMARK(BM_graph_by_account_degree)->Apply(small_blocks);
+BENCHMARK(BM_graph_by_hash_conflict)->Apply(large_blocks);
+BENCHMARK(BM_component_partition)->Apply(small_blocks);
+BENCHMARK(BM_dispatch_single_thread)->Apply(large_blocks);
+BENCHMARK(BM_dispatch_delay_conflicts)->Apply(large_blocks);
+BENCHMARK(BM_dispatch_graph)->Apply(large_blocks);
+BENCHMARK(BM_dispatch_csr_graph)->Apply(large_blocks);
+
+BENCHMARK_MAIN();
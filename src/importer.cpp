@@ -0,0 +1,344 @@
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_map>
+
+#include "runner.hpp"
+
+using namespace sched_bench;
+
+namespace {
+
+/**
+ * Streams a recorded trace one line at a time.  Account names are arbitrary strings that are remapped to dense ids in
+ * the order they are first seen, so memory is bounded by the imported workload rather than the size of the file.
+ */
+struct Trace_reader {
+    std::unordered_map<std::string, uint> account_ids;
+    std::vector<Account::Id> accounts;
+    std::vector<Account::Id> line_writes;
+    std::vector<Account::Id> line_reads;
+    std::string name;
+
+    void add_account(char const *begin, char const *end, std::vector<Account::Id> &out) {
+        name.assign(begin, end);
+        auto iter = account_ids.find(name);
+        if (iter == account_ids.end()) {
+            iter = account_ids.emplace(name, account_ids.size()).first;
+        }
+        out.push_back(Account::Id(iter->second));
+    }
+
+    static char const *skip_space(char const *pos, char const *end) {
+        while (pos < end && (*pos == ' ' || *pos == '\t' || *pos == '\r')) {
+            pos++;
+        }
+        return pos;
+    }
+
+    static char const *trim_back(char const *begin, char const *end) {
+        while (end > begin && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r')) {
+            end--;
+        }
+        return end;
+    }
+
+    static bool parse_cost(char const *begin, char const *end, double &cost) {
+        std::string text(begin, end);
+        char *parsed_end = nullptr;
+        cost = std::strtod(text.c_str(), &parsed_end);
+        return parsed_end != text.c_str() && *skip_space(parsed_end, text.c_str() + text.size()) == '\0' && cost >= 0.0;
+    }
+
+    void parse_csv_accounts(char const *account, char const *end, std::vector<Account::Id> &out) {
+        while (account < end) {
+            char const *next = std::find(account, end, ';');
+            char const *begin = skip_space(account, next);
+            char const *last = trim_back(begin, next);
+            if (begin < last) {
+                add_account(begin, last, out);
+            }
+            account = next + 1;
+        }
+    }
+
+    /**
+     * CSV: accounts[,cost_ms[,read_accounts]] where the accounts are separated by ';', e.g. "alice;bob,0.25,carol".
+     * The first list is written, the optional second list is only read.
+     */
+    bool parse_csv(char const *pos, char const *end, bool &has_cost, double &cost) {
+        char const *comma = std::find(pos, end, ',');
+        parse_csv_accounts(pos, comma, line_writes);
+
+        has_cost = false;
+        if (comma < end) {
+            char const *cost_end = std::find(comma + 1, end, ',');
+            char const *begin = skip_space(comma + 1, cost_end);
+            char const *last = trim_back(begin, cost_end);
+            if (begin < last) {
+                if (!parse_cost(begin, last, cost)) {
+                    return false;
+                }
+                has_cost = true;
+            }
+
+            if (cost_end < end) {
+                parse_csv_accounts(cost_end + 1, end, line_reads);
+            }
+        }
+
+        return true;
+    }
+
+    // JSON string without unicode escapes, which are kept verbatim since names only need to be distinct
+    static bool parse_string(char const *&pos, char const *end, std::string &out) {
+        out.clear();
+        pos++;
+        while (pos < end && *pos != '"') {
+            if (*pos == '\\' && pos + 1 < end) {
+                pos++;
+            }
+            out.push_back(*pos++);
+        }
+        if (pos >= end) {
+            return false;
+        }
+        pos++;
+        return true;
+    }
+
+    // skip any JSON value that we do not care about
+    static bool skip_value(char const *&pos, char const *end) {
+        std::string ignored;
+        pos = skip_space(pos, end);
+        if (pos >= end) {
+            return false;
+        }
+
+        if (*pos == '"') {
+            return parse_string(pos, end, ignored);
+        }
+
+        if (*pos == '[' || *pos == '{') {
+            uint depth = 0;
+            while (pos < end) {
+                if (*pos == '"') {
+                    if (!parse_string(pos, end, ignored)) {
+                        return false;
+                    }
+                    continue;
+                }
+                if (*pos == '[' || *pos == '{') {
+                    depth++;
+                } else if ((*pos == ']' || *pos == '}') && --depth == 0) {
+                    pos++;
+                    return true;
+                }
+                pos++;
+            }
+            return false;
+        }
+
+        while (pos < end && *pos != ',' && *pos != '}' && *pos != ']') {
+            pos++;
+        }
+        return true;
+    }
+
+    static char const *scalar_end(char const *pos, char const *end) {
+        while (pos < end && *pos != ',' && *pos != '}' && *pos != ']' && *pos != ' ' && *pos != '\t') {
+            pos++;
+        }
+        return pos;
+    }
+
+    bool parse_json_accounts(char const *&pos, char const *end, std::vector<Account::Id> &out) {
+        std::string account;
+        if (pos >= end || *pos != '[') {
+            return false;
+        }
+        pos = skip_space(pos + 1, end);
+        while (pos < end && *pos != ']') {
+            if (*pos == '"') {
+                if (!parse_string(pos, end, account)) {
+                    return false;
+                }
+                add_account(account.data(), account.data() + account.size(), out);
+            } else {
+                char const *last = scalar_end(pos, end);
+                if (last == pos) {
+                    return false;
+                }
+                add_account(pos, last, out);
+                pos = last;
+            }
+
+            pos = skip_space(pos, end);
+            if (pos < end && *pos == ',') {
+                pos = skip_space(pos + 1, end);
+            }
+        }
+        if (pos >= end) {
+            return false;
+        }
+        pos++;
+        return true;
+    }
+
+    /**
+     * JSONL: {"accounts": ["alice", "bob", 42], "reads": ["carol"], "cost": 0.25}, "writes" is accepted as another
+     * name for "accounts" and other keys are ignored
+     */
+    bool parse_json(char const *pos, char const *end, bool &has_cost, double &cost) {
+        std::string key;
+        has_cost = false;
+        pos = skip_space(pos, end);
+        if (pos >= end || *pos != '{') {
+            return false;
+        }
+        pos++;
+
+        while (true) {
+            pos = skip_space(pos, end);
+            if (pos < end && *pos == '}') {
+                return true;
+            }
+            if (pos >= end || *pos != '"' || !parse_string(pos, end, key)) {
+                return false;
+            }
+
+            pos = skip_space(pos, end);
+            if (pos >= end || *pos != ':') {
+                return false;
+            }
+            pos = skip_space(pos + 1, end);
+
+            if (key == "accounts" || key == "writes") {
+                if (!parse_json_accounts(pos, end, line_writes)) {
+                    return false;
+                }
+            } else if (key == "reads") {
+                if (!parse_json_accounts(pos, end, line_reads)) {
+                    return false;
+                }
+            } else if (key == "cost") {
+                char const *last = scalar_end(pos, end);
+                if (last - pos == 4 && std::equal(pos, last, "null")) {
+                    has_cost = false;
+                } else if (!parse_cost(pos, last, cost)) {
+                    return false;
+                } else {
+                    has_cost = true;
+                }
+                pos = last;
+            } else if (!skip_value(pos, end)) {
+                return false;
+            }
+
+            pos = skip_space(pos, end);
+            if (pos < end && *pos == ',') {
+                pos++;
+            } else if (pos >= end || *pos != '}') {
+                return false;
+            }
+        }
+    }
+};
+
+}
+
+bool Runner::import_workload(std::string const &filename, Config const &config, Workload &workload) {
+    SCOPE_PROFILE("Import Trace");
+    std::ifstream in(filename);
+    if (!in) {
+        std::cerr << "Unable to open trace file " << filename << "\n";
+        return false;
+    }
+
+    // transactions without a recorded cost draw one from the configured distribution
+    std::mt19937_64 prng(config.seed);
+    std::normal_distribution<> cost_dist(config.transaction_cost_ms_mean, config.transaction_cost_ms_stddev);
+
+    Trace_reader reader;
+    struct Slice {
+        std::size_t offset;
+        uint account_count;
+        uint write_count;
+    };
+    std::vector<Slice> slices;
+    workload.cost_storage.clear();
+
+    std::string line;
+    uint64_t line_number = 0;
+    uint64_t skipped = 0;
+    bool first_record = true;
+    while (std::getline(in, line)) {
+        line_number++;
+        char const *begin = Trace_reader::skip_space(line.data(), line.data() + line.size());
+        char const *end = Trace_reader::trim_back(begin, line.data() + line.size());
+        if (begin == end || *begin == '#') {
+            continue;
+        }
+
+        // an optional CSV header
+        bool header = end - begin >= 8 && std::equal(begin, begin + 8, "accounts") && (begin + 8 == end || begin[8] == ',');
+        if (first_record && header) {
+            first_record = false;
+            continue;
+        }
+        first_record = false;
+
+        bool has_cost = false;
+        double cost = 0.0;
+        reader.line_writes.clear();
+        reader.line_reads.clear();
+        bool parsed = (*begin == '{') ? reader.parse_json(begin, end, has_cost, cost) : reader.parse_csv(begin, end, has_cost, cost);
+        if (!parsed) {
+            std::cerr << "Invalid transaction on line " << line_number << " of " << filename << "\n";
+            return false;
+        }
+
+        // schedulers expect each account at most once per transaction, an account that is also written is not read
+        auto &writes = reader.line_writes;
+        auto &reads = reader.line_reads;
+        std::sort(writes.begin(), writes.end());
+        writes.erase(std::unique(writes.begin(), writes.end()), writes.end());
+        std::sort(reads.begin(), reads.end());
+        reads.erase(std::unique(reads.begin(), reads.end()), reads.end());
+        reads.erase(std::remove_if(reads.begin(), reads.end(), [&writes](Account::Id const &a) {
+            return std::binary_search(writes.begin(), writes.end(), a);
+        }), reads.end());
+        if (writes.empty() && reads.empty()) {
+            skipped++;
+            continue;
+        }
+
+        slices.push_back(Slice {reader.accounts.size(), static_cast<uint>(writes.size() + reads.size()), static_cast<uint>(writes.size())});
+        reader.accounts.insert(reader.accounts.end(), writes.begin(), writes.end());
+        reader.accounts.insert(reader.accounts.end(), reads.begin(), reads.end());
+        workload.cost_storage.push_back(has_cost ? std::max(0.001, cost) : std::max(0.001, cost_dist(prng)));
+    }
+
+    if (skipped > 0) {
+        util::output() << "Skipped " << skipped << " transactions without accounts\n";
+    }
+
+    // transaction ids are the order of the imported transactions, the views are created once the pool is complete
+    workload.seed = config.seed;
+    workload.account_storage = std::move(reader.accounts);
+    workload.transactions.clear();
+    workload.transactions.reserve(slices.size());
+    for (uint i = 0; i < slices.size(); i++) {
+        workload.transactions.emplace_back(Transaction::Id(i), util::Array_view<Account::Id>(workload.account_storage.data() + slices[i].offset, slices[i].account_count), slices[i].write_count);
+    }
+
+    workload.costs = workload.cost_storage;
+    workload.mapping.reset();
+    index_workload(workload);
+
+    util::output() << "Imported " << workload.transactions.size() << " transactions over " << reader.account_ids.size() << " accounts from " << filename << "\n";
+    return true;
+}
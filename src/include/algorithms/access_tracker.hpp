@@ -0,0 +1,43 @@
+#pragma once
+#include <vector>
+
+namespace sched_bench { namespace algorithms {
+
+/**
+ * The accesses to one account (or hash slot) that the next access has to wait for.  A write waits for every reader since
+ * the last write, or the last writer when there were none, and a read only waits for the last writer.  NODE is whatever
+ * the scheduler links, a const Transaction or a scheduler's own node type.
+ */
+template<typename NODE>
+struct Access_tracker {
+    NODE *writer = nullptr;
+    std::vector<NODE *> readers;
+
+    template<typename PREVIOUS>
+    void access(NODE &n, bool write, PREVIOUS &&previous) {
+        if (write) {
+            if (readers.empty()) {
+                if (writer != nullptr && writer != &n) {
+                    previous(*writer);
+                }
+            } else {
+                for (auto const &r: readers) {
+                    if (r != &n) {
+                        previous(*r);
+                    }
+                }
+                readers.clear();
+            }
+            writer = &n;
+        } else {
+            if (writer != nullptr && writer != &n) {
+                previous(*writer);
+            }
+            if (readers.empty() || readers.back() != &n) {
+                readers.push_back(&n);
+            }
+        }
+    }
+};
+
+}}
@@ -0,0 +1,58 @@
+#pragma once
+#include <map>
+#include <vector>
+#include "algorithms/graph.hpp"
+#include "util/array_view.hpp"
+
+namespace sched_bench { namespace algorithms {
+
+using model::Transaction;
+
+/**
+ * A dependency graph whose linear chains are dispatched as one unit.  The graph links the units, every unit is named by
+ * its head and the rest of the chain follows the head in the same dispatch.  Only the last transaction of a chain has
+ * links out of it, so finalizing a whole dispatch releases the same transactions as finalizing its tail.
+ */
+struct Fused_graph
+{
+    Graph graph;
+    std::map<Transaction::Id, std::vector<Transaction::Id>> chains;
+
+    struct Dispatcher
+    {
+        Fused_graph const &fused;
+        Graph::Dispatcher units;
+
+        std::vector<Transaction::Id> next() {
+            auto dispatch = units.next();
+            if (!dispatch.empty()) {
+                auto chain = fused.chains.find(dispatch.front());
+                if (chain != fused.chains.end()) {
+                    dispatch.insert(dispatch.end(), chain->second.begin(), chain->second.end());
+                }
+            }
+            return dispatch;
+        }
+
+        void finalize(std::vector<Transaction::Id> const &dispatch) {
+            units.finalize(dispatch);
+        }
+
+        bool empty() {
+            return units.empty();
+        }
+    };
+
+    static Dispatcher create_dispatcher(Fused_graph const &block) {
+        return Dispatcher {block, Graph::create_dispatcher(block.graph)};
+    }
+};
+
+/**
+ * Fuses every link from a transaction with one distinct child to a transaction with one distinct parent, so each
+ * maximal chain becomes a single dispatch.  A chain is cut before the transaction that would take its cost, from costs
+ * indexed by transaction id, past max_cost_ms.  Prints the dispatch counts before and after.
+ */
+Fused_graph fuse_chains(Graph const &graph, util::Array_view<double> costs, double max_cost_ms);
+
+}}
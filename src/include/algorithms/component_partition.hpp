@@ -0,0 +1,21 @@
+#pragma once
+
+#include "model/standard_block.hpp"
+#include "util/array_view.hpp"
+
+namespace sched_bench { namespace algorithms {
+using sched_bench::model::Standard_Block;
+using sched_bench::model::Transaction;
+
+/**
+ * Splits the transactions into independent components, the sets of transactions joined by accounts that some
+ * transaction writes, with a disjoint-set forest over the dense account ids.  The components are packed onto
+ * thread_count threads by total cost, largest first onto the least loaded thread, and every thread runs its components
+ * in input order as one span of cycle 0 so no thread ever waits on another.  A component costing more than an even
+ * share of the block would bound the whole schedule on its own, these are scheduled like delay_conflicts instead and
+ * the other components are fitted around their cycles, onto the threads a cycle leaves idle or into the cycle they
+ * lengthen least, with a last cycle for those that fit nowhere.  costs are indexed by transaction id.
+ */
+Standard_Block partition_by_component(std::vector<Transaction> const &transactions, util::Array_view<double> costs, uint thread_count);
+
+}}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "model/standard_block.hpp"
+
+namespace sched_bench { namespace algorithms {
+using sched_bench::model::Standard_Block;
+using sched_bench::model::Transaction;
+
+/**
+ * Colors the conflict graph with DSatur, placing every transaction in the lowest cycle none of its colored conflicts
+ * use.  The graph is never built, every account keeps the cycles its writers and its readers were placed in and the
+ * conflicts of a transaction are the writers of its accounts plus the readers of the accounts it writes.  Saturation is
+ * kept per account, the next transaction is the first uncolored one on the account whose transactions already use the
+ * most distinct cycles, which keeps the coloring linear where per-transaction saturation is quadratic in the
+ * transactions sharing a popular account.  Like delay_conflicts every transaction is its own span, conflicting
+ * transactions are always in different cycles and run in cycle order.
+ */
+Standard_Block color_by_saturation(std::vector<Transaction> const &transactions);
+
+/**
+ * The same coloring with a static order, the transactions with the most conflicts are placed first (Welsh-Powell)
+ */
+Standard_Block color_by_degree(std::vector<Transaction> const &transactions);
+
+}}
@@ -0,0 +1,164 @@
+#pragma once
+#include <algorithm>
+#include <vector>
+#include "model/transaction.hpp"
+#include "util/scope_profile.hpp"
+
+namespace sched_bench { namespace algorithms {
+
+using model::Transaction;
+
+struct Graph;
+
+/**
+ * Dependency graph in compressed sparse row form.  Nodes are dense indices, the out-links of node i are
+ * targets[offsets[i] .. offsets[i+1]) in the order they were added.
+ */
+struct Csr_graph
+{
+    static const uint NO_NODE = ~0u;
+
+    std::vector<Transaction::Id> ids;
+    std::vector<uint> index_by_id;
+    std::vector<uint> roots;
+    std::vector<uint> offsets;
+    std::vector<uint> targets;
+
+    uint node_count() const {
+        return ids.size();
+    }
+
+    uint link_count() const {
+        return targets.size();
+    }
+
+    struct Builder
+    {
+        std::vector<Transaction::Id> ids;
+        std::vector<uint> roots;
+        std::vector<std::pair<uint, uint>> links;
+
+        Builder(std::vector<Transaction::Id> _ids)
+            : ids(std::move(_ids))
+        {
+            roots.reserve(ids.size());
+        }
+
+        Builder(std::vector<Transaction> const &transactions) {
+            ids.reserve(transactions.size());
+            for (auto const &t: transactions) {
+                ids.emplace_back(t.id);
+            }
+            roots.reserve(transactions.size());
+            links.reserve(transactions.size() * 2);
+        }
+
+        void add_root(uint node) {
+            roots.emplace_back(node);
+        }
+
+        void add_link(uint from, uint to) {
+            links.emplace_back(from, to);
+        }
+
+        Csr_graph build() {
+            SCOPE_PROFILE("Build CSR");
+            Csr_graph result;
+            result.ids = std::move(ids);
+            result.roots = std::move(roots);
+
+            // counting sort the links by source, this is stable so each node keeps the order its links were added
+            result.offsets.assign(result.ids.size() + 1, 0);
+            for (auto const &l: links) {
+                result.offsets[l.first + 1]++;
+            }
+
+            for (uint i = 0; i < result.ids.size(); i++) {
+                result.offsets[i + 1] += result.offsets[i];
+            }
+
+            std::vector<uint> cursor(result.offsets.begin(), result.offsets.end() - 1);
+            result.targets.resize(links.size());
+            for (auto const &l: links) {
+                result.targets[cursor[l.first]++] = l.second;
+            }
+
+            uint max_id = 0;
+            for (auto const &id: result.ids) {
+                max_id = std::max(max_id, id.as_numeric());
+            }
+
+            result.index_by_id.assign(result.ids.empty() ? 0 : max_id + 1, NO_NODE);
+            for (uint i = 0; i < result.ids.size(); i++) {
+                result.index_by_id[result.ids[i].as_numeric()] = i;
+            }
+
+            links.clear();
+            links.shrink_to_fit();
+            return result;
+        }
+    };
+
+    struct Dispatcher
+    {
+        Csr_graph const &graph;
+        std::vector<uint> unmet_dependencies;
+        std::vector<uint> ready;
+        uint blocked;
+
+        std::vector<Transaction::Id> next() {
+            static auto empty = std::vector<Transaction::Id>();
+            if (ready.size() > 0)
+            {
+                auto node = ready.back();
+                ready.pop_back();
+                return std::vector<Transaction::Id> {{graph.ids[node]}};
+            }
+            else
+            {
+                return empty;
+            }
+        }
+
+        void finalize(std::vector<Transaction::Id> const &dispatch) {
+            for (auto const &t: dispatch) {
+                uint node = graph.index_by_id[t.as_numeric()];
+                for (uint l = graph.offsets[node]; l < graph.offsets[node + 1]; l++) {
+                    uint target = graph.targets[l];
+                    if (--unmet_dependencies[target] == 0) {
+                        ready.push_back(target);
+                        blocked--;
+                    }
+                }
+            }
+        }
+
+        bool empty() {
+            return ready.empty() && blocked == 0;
+        }
+    };
+
+    static Dispatcher create_dispatcher(Csr_graph const &block) {
+        std::vector<uint> unmet_dependencies(block.node_count(), 0);
+        uint blocked = 0;
+        for (auto const &target: block.targets) {
+            if (unmet_dependencies[target]++ == 0) {
+                blocked++;
+            }
+        }
+
+        std::vector<uint> ready(block.roots.begin(), block.roots.end());
+        ready.reserve(block.node_count());
+        return Dispatcher {block, std::move(unmet_dependencies), std::move(ready), blocked};
+    }
+};
+
+Csr_graph to_csr_graph(Graph const &graph);
+Csr_graph csr_graph_by_account_degree(std::vector<Transaction> const &transactions);
+Csr_graph csr_graph_by_account_degree_bucket(std::vector<Transaction> const &transactions);
+Csr_graph csr_graph_by_hash_conflict(std::vector<Transaction> const &transactions);
+
+// the CSR form of transitive_reduction in graph.hpp, node indices and ids are unchanged
+Csr_graph transitive_reduction(Csr_graph const &graph, uint max_visits = 256);
+
+}}
@@ -27,7 +27,9 @@ Standard_Block delay_conflicts(std::vector<Transaction> const &transactions) {
     postponed.reserve(transactions.size());
 
     int cycle = 0;
+    // accounts written and read by the transactions accepted this cycle, any number of readers may share an account
     std::vector<bool>  used(1024*1024);
+    std::vector<bool>  read(1024*1024);
     bool scheduled = true;
     while( scheduled ) {
         SCOPE_PROFILE("Process Cycle:", cycle);
@@ -37,16 +39,22 @@ Standard_Block delay_conflicts(std::vector<Transaction> const &transactions) {
             SCOPE_PROFILE("Scan for Transactions");
             for( auto t : current ) {
                 bool u = false;
-                for( const auto& a : t->accounts ) {
-                    if( used[a.as_numeric()%used.size()] ) {
+                for( uint i = 0; i < t->accounts.size(); i++ ) {
+                    auto slot = t->accounts[i].as_numeric()%used.size();
+                    if( used[slot] || (t->writes_account(i) && read[slot]) ) {
                         u = true;
                         postponed.push_back(t);
                         break;
                     }
                 }
                 if( !u ) {
-                    for( const auto& a : t->accounts ) {
-                        used[a.as_numeric()%used.size()] = true;
+                    for( uint i = 0; i < t->accounts.size(); i++ ) {
+                        auto slot = t->accounts[i].as_numeric()%used.size();
+                        if( t->writes_account(i) ) {
+                            used[slot] = true;
+                        } else {
+                            read[slot] = true;
+                        }
                     }
 
                     schedule.emplace_back(cycle, thread++, t->id);
@@ -59,6 +67,7 @@ Standard_Block delay_conflicts(std::vector<Transaction> const &transactions) {
             SCOPE_PROFILE("Reset Tracking");
             current.resize(0);
             used.resize(0); used.resize(1024*1024);
+            read.resize(0); read.resize(1024*1024);
             std::swap( current, postponed );
             ++cycle;        
         }
@@ -66,5 +75,10 @@ Standard_Block delay_conflicts(std::vector<Transaction> const &transactions) {
     return Standard_Block(schedule);
 }
 
+/**
+ * Produces the same schedule as delay_conflicts, tracking written and read accounts in a word bitset that is tested
+ * with AVX2 gathers where the CPU supports them and reset by clearing only the words touched during the cycle
+ */
+Standard_Block delay_conflicts_bitset(std::vector<Transaction> const &transactions);
 
-}}
\ No newline at end of file
+}}
@@ -62,7 +62,26 @@ struct Graph
 };
 
 Graph graph_by_account_degree(std::vector<Transaction> const &transactions);
+
+/**
+ * Produces the same graph as graph_by_account_degree using a bucket queue over account degrees and dense per-account
+ * transaction lists instead of ordered maps and sets
+ */
+Graph graph_by_account_degree_bucket(std::vector<Transaction> const &transactions);
 Graph graph_by_hash_conflict(std::vector<Transaction> const &transactions);
 
+/**
+ * Produces the same links as graph_by_hash_conflict by splitting the transactions into one chunk per thread, building
+ * per-chunk last-writer tables in parallel and stitching the chunk boundaries together
+ */
+Graph graph_by_hash_conflict_parallel(std::vector<Transaction> const &transactions, uint thread_count);
+
+/**
+ * Removes the links that other paths already imply, which saves the dispatcher a decrement and the graph a node per
+ * link.  A link is only dropped once a search of at most max_visits ancestors per node proves it redundant, so the
+ * reduction stays linear on huge graphs at the price of keeping some implied links.  Prints the link counts.
+ */
+Graph transitive_reduction(Graph const &graph, uint max_visits = 256);
+
 
 }}
\ No newline at end of file
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "model/standard_block.hpp"
+#include "util/array_view.hpp"
+
+namespace sched_bench { namespace algorithms {
+using sched_bench::model::Standard_Block;
+using sched_bench::model::Transaction;
+
+/**
+ * A cost-aware list scheduler in the spirit of HEFT.  Transactions are taken in input order and each is placed on the
+ * cycle and thread that grows the estimated makespan, the sum over cycles of the most loaded thread, the least.  A
+ * transaction may share a cycle with an earlier conflicting one only by running after it on the same thread, otherwise
+ * it goes to a later cycle.  costs are indexed by transaction id, at most thread_count threads are used per cycle.
+ */
+Standard_Block list_schedule_by_cost(std::vector<Transaction> const &transactions, util::Array_view<double> costs, uint thread_count);
+
+}}
@@ -0,0 +1,90 @@
+#pragma once
+#include <deque>
+#include <unordered_map>
+#include <vector>
+#include "algorithms/access_tracker.hpp"
+#include "model/transaction.hpp"
+
+namespace sched_bench { namespace algorithms {
+
+using model::Transaction;
+
+/**
+ * Streaming schedulers are handed the transactions of a block as they arrive instead of the whole block at once, and
+ * hand out dispatches as soon as they are safe to run.  They share a duck-typed interface with the block dispatchers:
+ *
+ *   push(t)            - a transaction arrived, it must outlive the scheduler
+ *   close()            - no more transactions will arrive
+ *   next()             - a dispatch that may run now, or an empty dispatch if there is none right now
+ *   finalize(dispatch) - a dispatch returned by next() has completed
+ *   empty()            - every transaction pushed so far has been finalized
+ *
+ * An empty next() before close() only means the scheduler is waiting for completions or more arrivals.
+ */
+
+/**
+ * Links each arriving transaction after the unfinished transactions that last accessed the same hash slots, the
+ * streaming counterpart of graph_by_hash_conflict.  Every transaction is its own dispatch, ready transactions are
+ * dispatched in arrival order.
+ */
+class Streaming_hash_conflict {
+public:
+    // the hash table is sized for the expected number of transactions, exactly as graph_by_hash_conflict does
+    explicit Streaming_hash_conflict(uint expected_transactions = 0);
+
+    void push(Transaction const &t);
+    void close();
+    std::vector<Transaction::Id> next();
+    void finalize(std::vector<Transaction::Id> const &dispatch);
+    bool empty() const;
+
+private:
+    struct Node {
+        Transaction const *transaction;
+        uint unmet;
+        bool done;
+        std::vector<Node *> dependents;
+    };
+
+    uint hash_size;
+    std::vector<Access_tracker<Node>> slots;
+
+    // nodes are never removed while the scheduler lives since the slots may still reference them
+    std::deque<Node> nodes;
+    std::deque<Node *> ready;
+    std::unordered_map<Transaction::Id::storage_type, Node *> running;
+    std::vector<Node *> previous;
+    uint remaining;
+};
+
+/**
+ * The streaming counterpart of delay_conflicts: transactions that do not conflict with the current cycle join it as
+ * they arrive, the rest wait for the next cycle.  A cycle ends once all of its transactions have completed, then the
+ * waiting transactions are scanned in arrival order to form the next one.  Every transaction is its own dispatch.
+ */
+class Streaming_delay_conflicts {
+public:
+    Streaming_delay_conflicts();
+
+    void push(Transaction const &t);
+    void close();
+    std::vector<Transaction::Id> next();
+    void finalize(std::vector<Transaction::Id> const &dispatch);
+    bool empty() const;
+
+private:
+    bool try_accept(Transaction const &t);
+    void start_cycle();
+
+    // written and read bits of each tracked account for the current cycle, accounts are tracked modulo the size
+    std::vector<uint8_t> used;
+    std::vector<uint> touched;
+
+    std::deque<Transaction const *> waiting;
+    std::deque<Transaction const *> ready;
+    uint outstanding;
+    uint remaining;
+    uint cycle;
+};
+
+}}
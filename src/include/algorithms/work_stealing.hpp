@@ -0,0 +1,119 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "algorithms/csr_graph.hpp"
+#include "util/work_stealing_deque.hpp"
+
+namespace sched_bench { namespace algorithms {
+
+using model::Transaction;
+
+/**
+ * Concurrent dispatcher for dependency graphs.  Every worker owns a deque of ready nodes and steals from the other
+ * workers when it runs dry.  Finalizing a transaction atomically decrements the dependency counters of its children
+ * and pushes the ones that became ready onto the finishing worker's own deque, so they tend to run on the same core.
+ */
+struct Work_stealing_dispatcher
+{
+    typedef std::chrono::steady_clock clock;
+    typedef std::chrono::duration<double, std::ratio<1, 1000>> duration_ms;
+
+    Csr_graph const &graph;
+    std::unique_ptr<std::atomic<uint>[]> unmet_dependencies;
+    std::vector<std::unique_ptr<util::Work_stealing_deque<uint>>> deques;
+    std::atomic<uint> remaining;
+    // nodes that are ready or running, if this hits zero while nodes remain the graph can never complete
+    std::atomic<uint> pending;
+    std::atomic_bool deadlocked;
+
+    Work_stealing_dispatcher(Csr_graph const &_graph, uint worker_count)
+        : graph(_graph)
+        , unmet_dependencies(new std::atomic<uint>[_graph.node_count()])
+        , remaining(_graph.node_count())
+        , pending(_graph.roots.size())
+        , deadlocked(false)
+    {
+        for (uint i = 0; i < graph.node_count(); i++) {
+            unmet_dependencies[i].store(0, std::memory_order_relaxed);
+        }
+
+        for (auto const &target: graph.targets) {
+            unmet_dependencies[target].fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // deal the roots out round-robin so every worker starts with something to do
+        for (uint w = 0; w < worker_count; w++) {
+            deques.emplace_back(new util::Work_stealing_deque<uint>(std::max<uint>(1024, graph.node_count() / worker_count)));
+        }
+
+        for (uint r = 0; r < graph.roots.size(); r++) {
+            deques[r % worker_count]->push(graph.roots[r]);
+        }
+    }
+
+    // returns an empty dispatch once every node has been finalized
+    template<typename STATS>
+    std::vector<Transaction::Id> acquire(uint worker, STATS &stats) {
+        uint node;
+        if (deques[worker]->pop(node)) {
+            return std::vector<Transaction::Id> {{graph.ids[node]}};
+        }
+
+        auto spin_start = clock::now();
+        uint const worker_count = deques.size();
+        while (remaining.load(std::memory_order_acquire) > 0) {
+            // remaining drops before pending does, so reload it, the last dispatch may have retired since the check above
+            if (pending.load(std::memory_order_acquire) == 0) {
+                if (remaining.load(std::memory_order_acquire) > 0) {
+                    deadlocked.store(true);
+                }
+                break;
+            }
+
+            for (uint i = 1; i < worker_count; i++) {
+                uint victim = (worker + i) % worker_count;
+                if (deques[victim]->steal(node)) {
+                    stats.steals++;
+                    stats.spin_ms += duration_ms(clock::now() - spin_start).count();
+                    return std::vector<Transaction::Id> {{graph.ids[node]}};
+                }
+            }
+
+            // a finalize on this thread is the only way our own deque refills, so just check the others again
+            std::this_thread::yield();
+        }
+
+        stats.spin_ms += duration_ms(clock::now() - spin_start).count();
+        return std::vector<Transaction::Id>();
+    }
+
+    void release(uint worker, std::vector<Transaction::Id> const &dispatch) {
+        auto &deque = *deques[worker];
+        for (auto const &t: dispatch) {
+            uint node = graph.index_by_id[t.as_numeric()];
+            for (uint l = graph.offsets[node]; l < graph.offsets[node + 1]; l++) {
+                uint target = graph.targets[l];
+                if (unmet_dependencies[target].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    pending.fetch_add(1, std::memory_order_relaxed);
+                    deque.push(target);
+                }
+            }
+        }
+
+        /**
+         * count the new ready nodes before retiring this dispatch so pending never reads zero while work exists, and
+         * retire it from remaining first so a worker that sees pending at zero sees the finished count with it
+         */
+        remaining.fetch_sub(dispatch.size(), std::memory_order_release);
+        pending.fetch_sub(dispatch.size(), std::memory_order_release);
+    }
+
+    bool failed() const {
+        return deadlocked.load();
+    }
+};
+
+}}
@@ -0,0 +1,319 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "algorithms/graph.hpp"
+#include "algorithms/work_stealing.hpp"
+#include "model/transaction.hpp"
+#include "util/array_view.hpp"
+#include "util/scope_profile.hpp"
+
+namespace sched_bench {
+using namespace model;
+
+/**
+ * Runs a schedule on a pool of real OS threads.  Each worker pulls dispatches from a shared dispatcher, burns CPU for
+ * the cost of every transaction in the dispatch and then finalizes it.  Unlike the simulator in the Runner, this
+ * exposes the cost of dispatcher contention, wakeups and synchronization.
+ */
+struct Executor {
+    typedef std::chrono::steady_clock clock;
+    typedef std::chrono::duration<double, std::ratio<1, 1000>> duration_ms;
+
+    struct Worker_stats {
+        uint dispatches;
+        uint transactions;
+        double busy_ms;
+        double wait_ms;
+
+        // only reported by the work-stealing dispatcher
+        uint steals;
+        double spin_ms;
+    };
+
+    struct Results {
+        double runtime_ms;
+        uint transactions_retired;
+        std::vector<Worker_stats> workers;
+        bool work_stealing;
+
+        bool valid;
+        std::string error_message;
+    };
+
+    /**
+     * Adapts a single-threaded dispatcher (Standard_Block::Dispatcher, Graph::Dispatcher) for use by many workers by
+     * serializing every call behind one mutex.  Workers with nothing to do sleep until a finalize may have made new
+     * work available.
+     */
+    template<typename DISPATCHER>
+    struct Locked_dispatcher {
+        Locked_dispatcher(DISPATCHER _dispatcher)
+            : dispatcher(std::move(_dispatcher))
+            , outstanding(0)
+            , done(false)
+            , deadlocked(false)
+        {
+        }
+
+        // returns an empty dispatch once there is nothing left for this worker to do
+        std::vector<Transaction::Id> acquire(uint, Worker_stats &) {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (!done) {
+                auto dispatch = dispatcher.next();
+                if (!dispatch.empty()) {
+                    outstanding++;
+                    return dispatch;
+                }
+
+                if (outstanding == 0) {
+                    // nothing in flight can unblock the dispatcher, so we are either done or deadlocked
+                    deadlocked = !dispatcher.empty();
+                    done = true;
+                    wakeup.notify_all();
+                } else {
+                    wakeup.wait(lock);
+                }
+            }
+
+            return std::vector<Transaction::Id>();
+        }
+
+        void release(uint, std::vector<Transaction::Id> const &dispatch) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                dispatcher.finalize(dispatch);
+                outstanding--;
+            }
+            wakeup.notify_all();
+        }
+
+        bool failed() const {
+            return deadlocked;
+        }
+
+        DISPATCHER dispatcher;
+        std::mutex mutex;
+        std::condition_variable wakeup;
+        uint outstanding;
+        bool done;
+        bool deadlocked;
+    };
+
+    /**
+     * Adapts a streaming scheduler (see algorithms/streaming.hpp) for use by many workers while a feeder thread pushes
+     * transactions into it.  Workers only give up once the stream is closed and nothing is in flight.
+     */
+    template<typename SCHEDULER>
+    struct Streaming_dispatcher {
+        Streaming_dispatcher(SCHEDULER _scheduler)
+            : scheduler(std::move(_scheduler))
+            , outstanding(0)
+            , closed(false)
+            , done(false)
+            , deadlocked(false)
+        {
+        }
+
+        std::vector<Transaction::Id> acquire(uint, Worker_stats &) {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (!done) {
+                auto dispatch = scheduler.next();
+                if (!dispatch.empty()) {
+                    outstanding++;
+                    return dispatch;
+                }
+
+                if (closed && outstanding == 0) {
+                    deadlocked = !scheduler.empty();
+                    done = true;
+                    wakeup.notify_all();
+                } else {
+                    wakeup.wait(lock);
+                }
+            }
+
+            return std::vector<Transaction::Id>();
+        }
+
+        void release(uint, std::vector<Transaction::Id> const &dispatch) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                scheduler.finalize(dispatch);
+                outstanding--;
+            }
+            wakeup.notify_all();
+        }
+
+        void push(Transaction const *begin, Transaction const *end) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                for (; begin < end; begin++) {
+                    scheduler.push(*begin);
+                }
+            }
+            wakeup.notify_all();
+        }
+
+        void close() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                scheduler.close();
+                closed = true;
+            }
+            wakeup.notify_all();
+        }
+
+        bool failed() const {
+            return deadlocked;
+        }
+
+        SCHEDULER scheduler;
+        std::mutex mutex;
+        std::condition_variable wakeup;
+        uint outstanding;
+        bool closed;
+        bool done;
+        bool deadlocked;
+    };
+
+    // spin the calling thread for the given number of milliseconds
+    static void burn(double ms) {
+        auto until = clock::now() + std::chrono::duration_cast<clock::duration>(duration_ms(ms));
+        while (clock::now() < until) {
+            // busy wait, this simulates the transaction doing real work
+        }
+    }
+
+    /**
+     * Execute a block produced by a scheduler using its own single-threaded dispatcher
+     */
+    template<typename BLOCK>
+    static Results execute(BLOCK const &block, util::Array_view<double> costs, uint thread_count, bool) {
+        Locked_dispatcher<decltype(BLOCK::create_dispatcher(block))> dispatcher(BLOCK::create_dispatcher(block));
+        return run(dispatcher, costs, thread_count);
+    }
+
+    /**
+     * Dependency graphs may optionally be executed by the concurrent work-stealing dispatcher
+     */
+    static Results execute(algorithms::Csr_graph const &block, util::Array_view<double> costs, uint thread_count, bool work_stealing) {
+        if (!work_stealing) {
+            return execute<algorithms::Csr_graph>(block, costs, thread_count, false);
+        }
+
+        algorithms::Work_stealing_dispatcher dispatcher(block, thread_count);
+        auto results = run(dispatcher, costs, thread_count);
+        results.work_stealing = true;
+        return results;
+    }
+
+    static Results execute(algorithms::Graph const &block, util::Array_view<double> costs, uint thread_count, bool work_stealing) {
+        if (!work_stealing) {
+            return execute<algorithms::Graph>(block, costs, thread_count, false);
+        }
+
+        auto const csr = algorithms::to_csr_graph(block);
+        return execute(csr, costs, thread_count, true);
+    }
+
+    /**
+     * Execute a streaming scheduler while a feeder thread pushes arrival_batch transactions every arrival_interval_ms.
+     * The runtime is end-to-end, from the first arrival until the last transaction completes.
+     */
+    template<typename SCHEDULER>
+    static Results execute_streaming(SCHEDULER scheduler, std::vector<Transaction> const &transactions, util::Array_view<double> costs, uint thread_count, double arrival_interval_ms, uint arrival_batch) {
+        Streaming_dispatcher<SCHEDULER> dispatcher(std::move(scheduler));
+        auto feed_start = clock::now();
+        std::thread feeder([&]() {
+            SCOPE_PROFILE("Feed Transactions");
+            for (std::size_t begin = 0, batch = 0; begin < transactions.size(); begin += arrival_batch, batch++) {
+                std::this_thread::sleep_until(feed_start + std::chrono::duration_cast<clock::duration>(duration_ms(arrival_interval_ms * batch)));
+                std::size_t end = std::min(transactions.size(), begin + arrival_batch);
+                dispatcher.push(transactions.data() + begin, transactions.data() + end);
+            }
+            dispatcher.close();
+        });
+
+        auto results = run(dispatcher, costs, thread_count);
+        feeder.join();
+        results.runtime_ms = duration_ms(clock::now() - feed_start).count();
+        return results;
+    }
+
+    /**
+     * Execute with any shared dispatcher that provides thread-safe acquire/release/failed
+     */
+    template<typename SHARED_DISPATCHER>
+    static Results run(SHARED_DISPATCHER &dispatcher, util::Array_view<double> costs, uint thread_count) {
+        SCOPE_PROFILE("Execute Threaded");
+        Results results;
+        results.workers.resize(thread_count);
+        results.work_stealing = false;
+
+        std::atomic_bool start(false);
+        auto worker_entry = [&](uint worker) {
+            while (!start.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+
+            SCOPE_PROFILE("Worker", worker);
+            // keep the stats local while running so workers do not share cache lines
+            Worker_stats stats {0, 0, 0.0, 0.0, 0, 0.0};
+            while (true) {
+                auto wait_start = clock::now();
+                auto dispatch = dispatcher.acquire(worker, stats);
+                auto work_start = clock::now();
+                stats.wait_ms += duration_ms(work_start - wait_start).count();
+                if (dispatch.empty()) {
+                    break;
+                }
+
+                for (auto const &t_id: dispatch) {
+                    burn(costs[t_id.as_numeric()]);
+                }
+
+                stats.busy_ms += duration_ms(clock::now() - work_start).count();
+                stats.dispatches++;
+                stats.transactions += dispatch.size();
+                dispatcher.release(worker, dispatch);
+            }
+
+            results.workers[worker] = stats;
+        };
+
+        std::vector<std::thread> workers;
+        workers.reserve(thread_count);
+        for (uint worker = 0; worker < thread_count; worker++) {
+            workers.emplace_back(worker_entry, worker);
+        }
+
+        auto exec_start = clock::now();
+        start.store(true, std::memory_order_release);
+        for (auto &w: workers) {
+            w.join();
+        }
+        auto exec_end = clock::now();
+
+        results.runtime_ms = duration_ms(exec_end - exec_start).count();
+        results.transactions_retired = 0;
+        for (auto const &w: results.workers) {
+            results.transactions_retired += w.transactions;
+        }
+
+        results.valid = !dispatcher.failed();
+        if (!results.valid) {
+            results.error_message = "DEADLOCK: all threads are idle but the dispatcher is not empty";
+        }
+
+        return results;
+    }
+};
+
+}
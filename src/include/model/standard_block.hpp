@@ -1,6 +1,9 @@
 #pragma once
 
+#include <algorithm>
+#include <vector>
 #include "transaction.hpp"
+#include "util/functional.hpp"
 #include "util/scope_profile.hpp"
 
 namespace sched_bench { namespace model {
@@ -34,7 +37,8 @@ struct Standard_Block {
         : transactions(std::move(_transactions))
     {
         SCOPE_PROFILE("Sort Transaction Schedule");
-        std::sort(transactions.begin(), transactions.end());
+        // the entries of one thread in one cycle run in the order they were scheduled
+        std::stable_sort(transactions.begin(), transactions.end());
     }
 
     struct Dispatcher {
@@ -1,4 +1,6 @@
 #pragma once
+#include <vector>
+#include "util/array_view.hpp"
 #include "util/numeric_id.hpp"
 #include "account.hpp"
 
@@ -6,15 +8,40 @@ namespace sched_bench { namespace model {
 
 struct Transaction {
     typedef util::Numeric_id<Transaction> Id;
-    
-    Transaction(Id _id, std::vector<Account::Id> _accounts )
+
+    // the account list is not owned, it points into a pool that must outlive the transaction (see Runner::Workload)
+    Transaction(Id _id, util::Array_view<Account::Id> _accounts )
+        : id(_id)
+        , accounts(_accounts)
+        , write_count(_accounts.size())
+    {
+    }
+
+    // the first _write_count accounts are written, the rest are only read
+    Transaction(Id _id, util::Array_view<Account::Id> _accounts, uint _write_count )
         : id(_id)
-        , accounts(std::move(_accounts))
+        , accounts(_accounts)
+        , write_count(_write_count)
     {
     }
 
+    bool writes_account(std::size_t index) const {
+        return index < write_count;
+    }
+
+    util::Array_view<Account::Id> writes() const {
+        return util::Array_view<Account::Id>(accounts.data(), write_count);
+    }
+
+    util::Array_view<Account::Id> reads() const {
+        return util::Array_view<Account::Id>(accounts.data() + write_count, accounts.size() - write_count);
+    }
+
     Id id;
-    std::vector<Account::Id> accounts;
+
+    // every account the transaction accesses, the written accounts first and then the read-only ones, each part sorted
+    util::Array_view<Account::Id> accounts;
+    uint write_count;
 };
 
 }}
@@ -2,15 +2,24 @@
 
 #include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <iostream>
 #include <map>
-#include <fstream>
+#include <memory>
+#include <queue>
+#include <string>
 #include <vector>
 #include <boost/format.hpp>
 #include <boost/algorithm/string/join.hpp>
+#include "executor.hpp"
+#include "model/standard_block.hpp"
 #include "model/transaction.hpp"
+#include "util/array_view.hpp"
 #include "util/functional.hpp"
+#include "util/mapped_file.hpp"
+#include "util/output.hpp"
 #include "util/scope_profile.hpp"
+#include "util/trace_sink.hpp"
 
 
 namespace sched_bench {
@@ -18,12 +27,67 @@ using namespace model;
 
 struct Runner {
 
+    /**
+     * The distribution of a scheduler's run times over the timed repetitions.  A result is noisy when the standard
+     * deviation is more than NOISY_CV of the mean, differences smaller than the spread should not be trusted.
+     */
+    struct Timing_stats {
+        static constexpr double NOISY_CV = 0.10;
+
+        uint samples;
+        double min_ms;
+        double median_ms;
+        double p90_ms;
+        double p99_ms;
+        double mean_ms;
+        double stddev_ms;
+        bool noisy;
+
+        static Timing_stats summarize(std::vector<double> samples);
+    };
+
+    /**
+     * What no schedule of a workload can beat: the longest cost-weighted chain of conflicting transactions taken in input
+     * order, where readers of an account only wait for its last writer, and the total work spread over every thread.
+     * A scheduler that reorders conflicting transactions is not bound by the critical path and may beat it.
+     */
+    struct Lower_bounds {
+        double critical_path_ms;
+        double work_ms;
+
+        double bound_ms() const {
+            return std::max(critical_path_ms, work_ms);
+        }
+    };
+
     struct Results {
         char const *scheduler;
         double duration_ms;
         double runtime_est_ms;
+        double runtime_measured_ms;
+        double latency_ms;
         uint transactions_retired;
 
+        // the units handed to the simulated threads, every dispatch costs a round trip through the dispatcher
+        uint dispatches;
+
+        // duration_ms is the median of the timed repetitions
+        Timing_stats timing;
+
+        /**
+         * the workload's lower bound and what percentage of the estimated runtime it is, 100% leaves no headroom.  A
+         * streaming run includes the time spent waiting for transactions to arrive, so it is held to the arrival-bound
+         * instead and its efficiency is taken against the end-to-end latency, which both measure from the first arrival
+         */
+        double lower_bound_ms;
+        double efficiency_pct;
+        bool streaming;
+
+        // the barriers of a cycle-based block and how many spans each cycle holds, 0 for blocks without cycles
+        uint cycles;
+        uint max_width;
+        double mean_width;
+
         bool valid;
         std::string error_message;
     };
@@ -36,9 +100,46 @@ struct Runner {
         double account_popularity_mean;
         double account_popularity_stddev;
         std::vector<double> pct_transactions_per_scope_count;
+        double read_fraction;
+        uint64_t seed;
 
         // analysis
         uint thread_count;
+        bool real_threads;
+        bool work_stealing;
+
+        // the most a fused chain of graph transactions may cost before it is cut into another dispatch
+        double fusion_max_cost_ms;
+
+        /**
+         * simulated overheads in milliseconds: from handing out a dispatch to its thread starting, of every next and
+         * finalize call and of releasing a cycle barrier.  A serialized dispatcher is a single-threaded resource whose
+         * calls queue up behind each other.
+         */
+        double dispatch_latency_ms;
+        double next_cost_ms;
+        double finalize_cost_ms;
+        double barrier_cost_ms;
+        bool serialize_dispatcher;
+
+        // host resources used by parallel schedulers
+        uint host_thread_count;
+
+        // every scheduler runs warmup untimed times and then repeat timed times on the same workload
+        uint repeat;
+        uint warmup;
+
+        // arrival of the transactions while the block is produced, arrival_batch transactions every arrival_interval_ms
+        double arrival_interval_ms;
+        uint arrival_batch;
+
+        // output
+        util::Trace_sink::Format trace_format;
+
+        // workload sources and snapshots, any may be empty
+        std::string save_workload_path;
+        std::string load_workload_path;
+        std::string import_trace_path;
 
         template<typename OP>
         void emit_properties(OP op) const {
@@ -49,144 +150,378 @@ struct Runner {
             op("transactionCount", std::to_string(transaction_count).c_str());
             op("scopePopularityMean", (boost::format{"%0.04f"} % account_popularity_mean).str().c_str() );
             op("scopePopularityStddev", (boost::format{"%0.04f"} % account_popularity_stddev).str().c_str() );
-            op("scopePopularityMean", (boost::format{"%0.04f"} % account_popularity_mean).str().c_str() );
             op("threadCount", std::to_string(thread_count).c_str() );
             op("transactionCostMean", (boost::format{"%0.04f"} % transaction_cost_ms_mean).str().c_str() );
             op("transactionCostStddev", (boost::format{"%0.04f"} % transaction_cost_ms_stddev).str().c_str() );
+            op("arrivalIntervalMs", (boost::format{"%0.04f"} % arrival_interval_ms).str().c_str() );
+            op("arrivalBatch", std::to_string(arrival_batch).c_str() );
+            op("repeat", std::to_string(repeat).c_str() );
+            op("warmup", std::to_string(warmup).c_str() );
+            op("fusionMaxCostMs", (boost::format{"%0.04f"} % fusion_max_cost_ms).str().c_str() );
+            op("dispatchLatencyMs", (boost::format{"%0.04f"} % dispatch_latency_ms).str().c_str() );
+            op("nextCostMs", (boost::format{"%0.04f"} % next_cost_ms).str().c_str() );
+            op("finalizeCostMs", (boost::format{"%0.04f"} % finalize_cost_ms).str().c_str() );
+            op("barrierCostMs", (boost::format{"%0.04f"} % barrier_cost_ms).str().c_str() );
+            op("serializeDispatcher", serialize_dispatcher ? "true" : "false" );
+            op("readFraction", (boost::format{"%0.04f"} % read_fraction).str().c_str() );
+            op("seed", std::to_string(seed).c_str() );
             op("scopeDegreeDist", (boost::format{"[%s]"} % boost::algorithm::join(scope_dist_strs, ", ")).str().c_str() );
         }
     };
 
-    static std::vector<Transaction> generate_transactions(Config const &config);
-    static std::map<Transaction::Id, double> generate_costs(std::vector<Transaction> const &transactions, Config const &config);
+    struct Scaling_results {
+        uint thread_count;
+        double duration_ms;
+    };
+
+    /**
+     * a generated or loaded block of transactions with dense, id-indexed lookups for the simulator
+     *
+     * transactions and costs are views into storage owned by the workload, either the generated vectors or a mapped
+     * snapshot file, so a workload can be moved but not copied
+     */
+    struct Workload {
+        Workload() = default;
+        Workload(Workload &&) = default;
+        Workload& operator= (Workload &&) = default;
+        Workload(Workload const &) = delete;
+        Workload& operator= (Workload const &) = delete;
+
+        std::vector<Transaction> transactions;
+        util::Array_view<double> costs;
+        std::vector<Transaction const *> by_id;
+        uint account_count;
+        uint64_t seed;
+
+        std::vector<Account::Id> account_storage;
+        std::vector<double> cost_storage;
+        std::unique_ptr<util::Mapped_file> mapping;
+    };
+
+    // completion events ordered by time, ties complete in the order they were dispatched
+    struct Completion {
+        double time;
+        uint64_t sequence;
+        uint thread_id;
+
+        struct After {
+            bool operator() (Completion const &l, Completion const &r) const {
+                return r.time < l.time || (!(l.time < r.time) && r.sequence < l.sequence);
+            }
+        };
+    };
+
+    typedef std::priority_queue<Completion, std::vector<Completion>, Completion::After> Completion_queue;
+
+    /**
+     * The scopes held by the simulated dispatches: the number of dispatches reading each scope, or WRITE_LOCKED while a
+     * dispatch writes it.  A dispatch that both reads and writes a scope holds the write lock, its read locks are absorbed
+     */
+    struct Scope_locks {
+        static constexpr uint WRITE_LOCKED = ~0u;
+        static constexpr char const *VIOLATION = "ACCESS VIOLATION: a scope is written while a parallel dispatch is accessing it";
+
+        explicit Scope_locks(Workload const &_workload)
+            : workload(_workload)
+            , locks(_workload.account_count, 0)
+        {
+        }
+
+        // true if no other dispatch writes a scope the dispatch accesses or reads a scope it writes
+        bool available(std::vector<Transaction::Id> const &dispatch) const {
+            for (auto const &t_id: dispatch) {
+                auto t = workload.by_id[t_id.as_numeric()];
+                for (uint a = 0; a < t->accounts.size(); a++) {
+                    auto lock = locks[t->accounts[a].as_numeric()];
+                    if (t->writes_account(a) ? lock != 0 : lock == WRITE_LOCKED) {
+                        return false;
+                    }
+                }
+            }
+            return true;
+        }
+
+        void acquire(std::vector<Transaction::Id> const &dispatch) {
+            for (auto const &t_id: dispatch) {
+                auto t = workload.by_id[t_id.as_numeric()];
+                for (uint a = 0; a < t->accounts.size(); a++) {
+                    auto &lock = locks[t->accounts[a].as_numeric()];
+                    if (t->writes_account(a)) {
+                        lock = WRITE_LOCKED;
+                    } else if (lock != WRITE_LOCKED) {
+                        lock++;
+                    }
+                }
+            }
+        }
+
+        void release(std::vector<Transaction::Id> const &dispatch) {
+            for (auto const &t_id: dispatch) {
+                auto t = workload.by_id[t_id.as_numeric()];
+                for (uint a = 0; a < t->accounts.size(); a++) {
+                    auto &lock = locks[t->accounts[a].as_numeric()];
+                    if (t->writes_account(a)) {
+                        lock = 0;
+                    } else if (lock != WRITE_LOCKED && lock > 0) {
+                        lock--;
+                    }
+                }
+            }
+        }
+
+        Workload const &workload;
+        std::vector<uint> locks;
+    };
+
+    /**
+     * Charges the simulated dispatcher overheads.  Calls into a serialized dispatcher start once the previous call is
+     * done, otherwise a call only delays the thread that makes it.
+     */
+    struct Dispatcher_clock {
+        explicit Dispatcher_clock(Config const &_config)
+            : config(_config)
+            , free(0.0)
+        {
+        }
+
+        // a call that may start at `at` and takes cost, returns the time it is done
+        double call(double at, double cost) {
+            if (!config.serialize_dispatcher) {
+                return at + cost;
+            }
+
+            free = std::max(at, free) + cost;
+            return free;
+        }
+
+        Config const &config;
+        double free;
+    };
+
+    // the cycle of the dispatcher's last dispatch, dispatchers without barriers are always in cycle 0
+    static uint current_cycle(Standard_Block::Dispatcher const &dispatcher) {
+        return dispatcher.current_cycle;
+    }
+
+    template<typename DISPATCHER>
+    static uint current_cycle(DISPATCHER const &) {
+        return 0;
+    }
+
+    /**
+     * Marks a streaming scheduler for execute, FACTORY(expected_transactions) creates a fresh scheduler for every run
+     */
+    template<typename FACTORY>
+    struct Streaming {
+        FACTORY create;
+    };
+
+    template<typename FACTORY>
+    static Streaming<FACTORY> streaming(FACTORY factory) {
+        return Streaming<FACTORY> {factory};
+    }
+
+    // transactions arrive arrival_batch at a time, one batch every arrival_interval_ms starting at 0
+    static double arrival_ms(Config const &config, std::size_t index) {
+        return config.arrival_interval_ms * (index / std::max(1u, config.arrival_batch));
+    }
+
+    static double last_arrival_ms(Config const &config, std::size_t count) {
+        return count == 0 ? 0.0 : arrival_ms(config, count - 1);
+    }
+
+    static std::vector<Transaction> generate_transactions(Config const &config, std::vector<Account::Id> &account_storage);
+    static std::vector<double> generate_costs(std::vector<Transaction> const &transactions, Config const &config);
+    static Workload generate_workload(Config const &config);
+
+    /**
+     * Workload snapshots are flat, versioned binary files that are mapped and used in place when loaded.  They are
+     * written in native byte order ("SBWORK01", see runner.cpp for the layout).  Both print the reason and return false
+     * on failure.
+     */
+    static bool save_workload(Workload const &workload, std::string const &filename);
+    static bool load_workload(std::string const &filename, Workload &workload);
+
+    /**
+     * Streams a recorded trace with one transaction per line, either CSV "alice;bob,0.25,carol" (written accounts
+     * separated by ';', an optional cost in milliseconds and optional read-only accounts) or JSONL
+     * {"accounts": ["alice", "bob"], "reads": ["carol"], "cost": 0.25}.  Account names are remapped to dense ids and
+     * missing costs are drawn from the configured cost distribution.
+     */
+    static bool import_workload(std::string const &filename, Config const &config, Workload &workload);
+
+    // fill in the id-indexed lookups once the transactions and costs are in place
+    static void index_workload(Workload &workload);
+
+    // generate, load or import the workload described by the config, a loaded or imported workload's transaction count
+    // and seed are copied into the config so everything it emits describes the block that was used
+    static bool prepare_workload(Config &config, Workload &workload);
+
+    // one pass over the transactions with dense per-account state
+    static Lower_bounds lower_bounds(Workload const &workload, uint thread_count);
+
+    // the same bounds measured from the first arrival when no transaction can start before it arrives
+    static Lower_bounds arrival_lower_bounds(Workload const &workload, Config const &config);
+
+    // fill in the cycle count and widths of a block, only Standard_Block has cycles
+    static void measure_cycles(Standard_Block const &block, Results &results);
+
+    template<typename BLOCK>
+    static void measure_cycles(BLOCK const &, Results &) {
+    }
+
+    /**
+     * Cost-aware schedulers take fn(transactions, costs, thread_count) and are handed the workload's costs as their
+     * estimates and the simulated thread count, every other scheduler only sees the transactions
+     */
+    template<typename SCHED_FN>
+    static auto schedule(SCHED_FN &fn, Workload const &workload, Config const &config, int) -> decltype(fn(workload.transactions, workload.costs, config.thread_count)) {
+        return fn(workload.transactions, workload.costs, config.thread_count);
+    }
+
+    template<typename SCHED_FN>
+    static auto schedule(SCHED_FN &fn, Workload const &workload, Config const &, long) -> decltype(fn(workload.transactions)) {
+        return fn(workload.transactions);
+    }
+
+    template<typename SCHED_FN>
+    static auto schedule(SCHED_FN &fn, Workload const &workload, Config const &config) -> decltype(schedule(fn, workload, config, 0)) {
+        return schedule(fn, workload, config, 0);
+    }
 
     template<typename SCHED_FN>
-    static Results execute_one(std::vector<Transaction> const &transactions, std::map<Transaction::Id, double> const &costs, std::map<Transaction::Id, Transaction const *> const &tx_by_id, Config const &config, char const *fn_name, SCHED_FN fn) {
+    static Results execute_one(Workload const &workload, Config const &config, char const *fn_name, SCHED_FN fn) {
         SCOPE_PROFILE("Execute:", fn_name);
         Results results;
         results.valid = true;
         results.transactions_retired = 0;
+        results.dispatches = 0;
+        results.runtime_measured_ms = 0.0;
+        results.latency_ms = 0.0;
+        results.lower_bound_ms = 0.0;
+        results.efficiency_pct = 0.0;
+        results.streaming = false;
+        results.cycles = 0;
+        results.max_width = 0;
+        results.mean_width = 0.0;
         results.scheduler = fn_name;
 
-        std::cout << boost::format {"Scheduling[%s]\n"} % fn_name;
-        auto run_schedule_fn = [](Results &results, SCHED_FN fn, std::vector<Transaction> const &transactions) {
+        util::output() << boost::format {"Scheduling[%s]\n"} % fn_name;
+        auto run_schedule_fn = [&config](Results &results, SCHED_FN fn, Workload const &workload) {
             SCOPE_PROFILE("Schedule");
-            auto sched_start = std::chrono::steady_clock::now();
-            auto const block = fn(transactions);
-            auto sched_end = std::chrono::steady_clock::now();
-            results.duration_ms = (std::chrono::duration_cast<std::chrono::duration<double, std::ratio<1, 1000>>>(sched_end - sched_start)).count();
+            // warm caches, the allocator and first-touch page faults, these blocks are thrown away
+            for (uint i = 0; i < config.warmup; i++) {
+                SCOPE_PROFILE("Warmup", i);
+                schedule(fn, workload, config);
+            }
+
+            std::vector<double> samples;
+            auto timed_run = [&]() {
+                SCOPE_PROFILE("Timed Run", samples.size());
+                auto sched_start = std::chrono::steady_clock::now();
+                auto block = schedule(fn, workload, config);
+                auto sched_end = std::chrono::steady_clock::now();
+                samples.push_back((std::chrono::duration_cast<std::chrono::duration<double, std::ratio<1, 1000>>>(sched_end - sched_start)).count());
+                return block;
+            };
+
+            // only the block of the last repetition is kept for validation
+            for (uint i = 1; i < config.repeat; i++) {
+                timed_run();
+            }
+            auto const block = timed_run();
+
+            results.timing = Timing_stats::summarize(std::move(samples));
+            results.duration_ms = results.timing.median_ms;
             return block;
         };
 
-        auto block = run_schedule_fn(results, fn, transactions);
+        auto block = run_schedule_fn(results, fn, workload);
+        measure_cycles(block, results);
 
-        std::cout << boost::format {"Validating/Estimating[%s]\n"} % fn_name;
+        util::output() << boost::format {"Validating/Estimating[%s]\n"} % fn_name;
         {
             SCOPE_PROFILE("Validate/Estimate");
             // validate and estimate
-            std::ofstream trace_file((boost::format{"%s.trace"} % fn_name).str());
+            auto const &costs = workload.costs;
+            util::Trace_sink trace(fn_name, config.trace_format);
             std::vector<uint> idle_threads = util::map<>(std::vector<uint>(config.thread_count), [](uint const &, uint i) -> uint { return i; });
             std::reverse(idle_threads.begin(), idle_threads.end());
             double now = 0;
             auto dispatcher = decltype(block)::create_dispatcher(block);
             auto dispatch = dispatcher.next();
-            std::multimap<double, std::pair<uint, decltype(dispatch)>> working_threads;
+            uint dispatch_cycle = current_cycle(dispatcher);
+            uint running_cycle = dispatch_cycle;
+            Dispatcher_clock dispatcher_clock(config);
+
+            Completion_queue working_threads;
+            std::vector<decltype(dispatch)> running_dispatches(config.thread_count);
             uint t_id = 0;
-            char const *sep = "";
 
-            trace_file << "{ \"traceEvents\": [\n";
             bool done=false;
-            std::set<Account::Id> locked_accounts;
+            Scope_locks locks(workload);
             while(!done) {
                 // find/assign to a thread 
                 if (!idle_threads.empty() && !dispatch.empty()) {
                     double cost = 0.0;
                     for (auto const &t_id: dispatch) {
-                        cost += costs.at(t_id);
-                        auto t = tx_by_id.at(t_id);
-                        for (auto const &a_id: t->accounts) {
-                            if (locked_accounts.find(a_id) != locked_accounts.end()) {
-                                results.valid = false;
-                                results.error_message = "ACCESS VIOLATION: two parallel dispatches are accessing the same scope";
-                                done = true;
-                            }
-                        }
+                        cost += costs[t_id.as_numeric()];
+                    }
 
+                    if (!locks.available(dispatch)) {
+                        results.valid = false;
+                        results.error_message = Scope_locks::VIOLATION;
+                        done = true;
                     }
 
                     if (!done) {
+                        // the first dispatch of a cycle also pays for releasing the barrier before it
+                        double overhead = config.next_cost_ms + (dispatch_cycle != running_cycle ? config.barrier_cost_ms : 0.0);
+                        running_cycle = dispatch_cycle;
+                        double start = dispatcher_clock.call(now, overhead) + config.dispatch_latency_ms;
+
                         uint thread_id = idle_threads.back();
                         idle_threads.pop_back();
-                        working_threads.emplace(std::make_pair(now + cost, std::make_pair(thread_id, dispatch)));
-
-                        for (auto const &t_id: dispatch) {
-                            auto t = tx_by_id.at(t_id);
-                            for (auto const &a_id: t->accounts) {
-                                locked_accounts.emplace(a_id);
-                            }
-
-                        }
+                        working_threads.push(Completion {start + cost, t_id, thread_id});
+                        locks.acquire(dispatch);
 
-                        trace_file 
-                            << sep
-                            << boost::format { "{\"tid\":%d,\"pid\":%d,\"ts\":%d,\"ph\":\"B\",\"cat\":\"T\",\"name\":\"D:%d\",\"args\":{\"txs\":[" }
-                            % thread_id
-                            % thread_id
-                            % std::llrint(std::floor(now * 1000.0))
-                            % t_id ; 
-
-                        char const *t_sep = "";
-                        for (auto const &id: dispatch) {
-                            trace_file << t_sep << id.as_numeric();
-                            t_sep = ",";
-                        }
-
-                        trace_file << "]}}";
+                        trace.begin(thread_id, std::llrint(std::floor(start * 1000.0)), t_id, dispatch);
                         t_id++;
-                        sep = ",\n";
 
                         // grab the next 
+                        running_dispatches[thread_id] = std::move(dispatch);
                         dispatch = dispatcher.next();
+                        dispatch_cycle = current_cycle(dispatcher);
                     }
                 } else if (!working_threads.empty()) {
                     // forward time to clear some jobs
-                    auto iter = working_threads.begin();
-                    auto next_complete = *iter;
-                    working_threads.erase(iter);
-                    uint thread_id = next_complete.second.first;
-                    auto completed_dispatch = next_complete.second.second;
-                    double completed_time = next_complete.first;
+                    auto next_complete = working_threads.top();
+                    working_threads.pop();
+                    uint thread_id = next_complete.thread_id;
+                    auto const &completed_dispatch = running_dispatches[thread_id];
+                    double completed_time = next_complete.time;
 
                     results.transactions_retired += completed_dispatch.size();
 
+                    // the thread finalizes its own dispatch, nothing it releases can start before that is done
                     dispatcher.finalize(completed_dispatch);
                     idle_threads.push_back(thread_id);
-                    now = completed_time;
-
-                    trace_file 
-                        << sep
-                        << boost::format { "{\"tid\":%d,\"pid\":%d,\"ts\":%d,\"ph\":\"E\"}" }
-                        % thread_id
-                        % thread_id
-                        % std::llrint(std::floor(now * 1000.0));
-
-                    for (auto const &t_id: completed_dispatch) {
-                        auto t = tx_by_id.at(t_id);
-                        for (auto const &a_id: t->accounts) {
-                            locked_accounts.erase(a_id);
-                        }
+                    now = std::max(now, dispatcher_clock.call(completed_time, config.finalize_cost_ms));
 
-                    }
+                    trace.end(thread_id, std::llrint(std::floor(completed_time * 1000.0)));
+
+                    locks.release(completed_dispatch);
 
                     // if our last dispatch was empty, 
                     if (dispatch.empty()) {
                         dispatch = dispatcher.next();
+                        dispatch_cycle = current_cycle(dispatcher);
                     }
                 } else if (working_threads.empty()) {
                     // done processing jobs
                     if(!dispatcher.empty()) {
                         results.valid = false;
-                        results.error_message = "DEADLOCK: all threads are idle but the dispather is not empty";
+                        results.error_message = "DEADLOCK: all threads are idle but the dispatcher is not empty";
                     }
 
                     done = true;
@@ -195,91 +530,347 @@ struct Runner {
 
             if (results.valid) {
                 results.runtime_est_ms = now;
+                // a block scheduler can only start once the last transaction has arrived and only dispatch once it is done
+                results.latency_ms = last_arrival_ms(config, workload.transactions.size()) + results.duration_ms + results.runtime_est_ms;
             } else {
                 results.runtime_est_ms = 0.0;
+                results.latency_ms = 0.0;
             }
 
-            trace_file 
-                << boost::format { "\n], \"schedulerName\":\"%s\"\n, \"estimatedRuntimeMs\": %f,\n \"schedulerTimeMs\": %f,\n \"retiredTransactons\": %d\n" }
-                % fn_name
-                % results.runtime_est_ms
-                % results.duration_ms
-                % results.transactions_retired;
+            trace.add_property("schedulerName", fn_name);
+            trace.add_property("estimatedRuntimeMs", results.runtime_est_ms);
+            trace.add_property("schedulerTimeMs", results.duration_ms);
+            trace.add_property("latencyMs", results.latency_ms);
+            trace.add_property("retiredTransactons", results.transactions_retired);
+            results.dispatches = t_id;
+            trace.add_property("dispatches", results.dispatches);
+            if (results.cycles > 0) {
+                trace.add_property("cycles", results.cycles);
+                trace.add_property("maxCycleWidth", results.max_width);
+            }
 
             if (!results.valid) {
-                trace_file
-                    << boost::format { "\"valid\":false\n, \"errorMessage\": \"%s\",\n" }
-                    % results.error_message;
+                trace.add_property("valid", false);
+                trace.add_property("errorMessage", results.error_message.c_str());
             }
 
             config.emit_properties([&](char const *k, char const *v) {
-                trace_file << boost::format {",\n\"%s\":\"%s\""} % k % v;
+                trace.add_property(k, v);
             });
 
-            trace_file << "\n}";
-                
-            trace_file.close();
+            trace.close();
+        }
+
+        if (config.real_threads && results.valid) {
+            util::output() << boost::format {"Executing[%s]\n"} % fn_name;
+            auto executed = Executor::execute(block, workload.costs, config.thread_count, config.work_stealing);
+            if (executed.valid) {
+                results.runtime_measured_ms = executed.runtime_ms;
+            } else {
+                results.valid = false;
+                results.error_message = executed.error_message;
+            }
+
+            double busy_ms = 0.0;
+            double wait_ms = 0.0;
+            for (auto const &w: executed.workers) {
+                busy_ms += w.busy_ms;
+                wait_ms += w.wait_ms;
+            }
+
+            util::output() 
+                << boost::format {"  Wall Clock: %0.03fms (%0.03fms estimated), Busy: %0.03fms, Waiting: %0.03fms, Retired: %d\n"}
+                % executed.runtime_ms
+                % results.runtime_est_ms
+                % busy_ms
+                % wait_ms
+                % executed.transactions_retired;
+
+            if (executed.work_stealing) {
+                for (uint w = 0; w < executed.workers.size(); w++) {
+                    auto const &worker = executed.workers[w];
+                    util::output() 
+                        << boost::format {"    Worker %d: %d dispatches, %d steals, %0.03fms spinning on empty queues\n"}
+                        % w
+                        % worker.dispatches
+                        % worker.steals
+                        % worker.spin_ms;
+                }
+            }
         }
         
         return results;
     }
 
+    /**
+     * Simulate a streaming scheduler while the transactions arrive.  The scheduler runs on one host thread beside the
+     * simulated workers, every call into it is timed and whatever it returns is only available once the scheduler is
+     * free again, so scheduling and execution overlap and the latency is end-to-end from the first arrival.
+     */
+    template<typename FACTORY>
+    static Results execute_one(Workload const &workload, Config const &config, char const *fn_name, Streaming<FACTORY> streaming) {
+        SCOPE_PROFILE("Execute:", fn_name);
+        typedef std::chrono::steady_clock clock;
+        typedef std::chrono::duration<double, std::ratio<1, 1000>> duration_ms;
+        Results results;
+        results.valid = true;
+        results.transactions_retired = 0;
+        results.dispatches = 0;
+        results.runtime_measured_ms = 0.0;
+        results.duration_ms = 0.0;
+        results.lower_bound_ms = 0.0;
+        results.efficiency_pct = 0.0;
+        results.streaming = true;
+        results.cycles = 0;
+        results.max_width = 0;
+        results.mean_width = 0.0;
+        results.scheduler = fn_name;
+
+        util::output() << boost::format {"Streaming[%s]\n"} % fn_name;
+        {
+            SCOPE_PROFILE("Simulate Streaming");
+            auto const &transactions = workload.transactions;
+            auto scheduler = streaming.create(transactions.size());
+            util::Trace_sink trace(fn_name, config.trace_format);
+            std::vector<uint> idle_threads = util::map<>(std::vector<uint>(config.thread_count), [](uint const &, uint i) -> uint { return i; });
+            std::reverse(idle_threads.begin(), idle_threads.end());
+            Completion_queue working_threads;
+            std::vector<std::vector<Transaction::Id>> running_dispatches(config.thread_count);
+            Scope_locks locks(workload);
+
+            double now = 0.0;
+            double scheduler_free = 0.0;
+            double first_dispatch = -1.0;
+            auto timed = [&](double at, auto &&call) {
+                auto start = clock::now();
+                call();
+                double elapsed = duration_ms(clock::now() - start).count();
+                results.duration_ms += elapsed;
+                scheduler_free = std::max(at, scheduler_free) + elapsed;
+                return scheduler_free;
+            };
+
+            uint t_id = 0;
+            std::size_t next_arrival = 0;
+            while (true) {
+                // hand out everything that is ready while there are idle threads
+                while (!idle_threads.empty()) {
+                    std::vector<Transaction::Id> dispatch;
+                    double dispatched = timed(now, [&]() { dispatch = scheduler.next(); });
+                    if (dispatch.empty()) {
+                        break;
+                    }
+
+                    // the streaming scheduler is always serialized, the modelled costs queue up behind its measured ones
+                    scheduler_free += config.next_cost_ms;
+                    dispatched = scheduler_free + config.dispatch_latency_ms;
+
+                    if (!locks.available(dispatch)) {
+                        results.valid = false;
+                        results.error_message = Scope_locks::VIOLATION;
+                        break;
+                    }
+
+                    double cost = 0.0;
+                    for (auto const &id: dispatch) {
+                        cost += workload.costs[id.as_numeric()];
+                    }
+
+                    uint thread_id = idle_threads.back();
+                    idle_threads.pop_back();
+                    working_threads.push(Completion {dispatched + cost, t_id, thread_id});
+                    locks.acquire(dispatch);
+                    trace.begin(thread_id, std::llrint(std::floor(dispatched * 1000.0)), t_id, dispatch);
+                    t_id++;
+                    if (first_dispatch < 0.0) {
+                        first_dispatch = dispatched;
+                    }
+                    running_dispatches[thread_id] = std::move(dispatch);
+                }
+
+                if (!results.valid) {
+                    break;
+                }
+
+                if (next_arrival < transactions.size() && (working_threads.empty() || arrival_ms(config, next_arrival) <= working_threads.top().time)) {
+                    // the next batch arrives before anything completes
+                    now = std::max(now, arrival_ms(config, next_arrival));
+                    std::size_t batch_end = std::min(transactions.size(), next_arrival + std::max(1u, config.arrival_batch));
+                    timed(now, [&]() {
+                        for (; next_arrival < batch_end; next_arrival++) {
+                            scheduler.push(transactions[next_arrival]);
+                        }
+                        if (next_arrival == transactions.size()) {
+                            scheduler.close();
+                        }
+                    });
+                } else if (!working_threads.empty()) {
+                    auto next_complete = working_threads.top();
+                    working_threads.pop();
+                    uint thread_id = next_complete.thread_id;
+                    auto const &completed_dispatch = running_dispatches[thread_id];
+                    now = std::max(now, next_complete.time);
+
+                    results.transactions_retired += completed_dispatch.size();
+                    timed(now, [&]() { scheduler.finalize(completed_dispatch); });
+                    scheduler_free += config.finalize_cost_ms;
+                    locks.release(completed_dispatch);
+                    idle_threads.push_back(thread_id);
+                    trace.end(thread_id, std::llrint(std::floor(next_complete.time * 1000.0)));
+                } else {
+                    if (!scheduler.empty()) {
+                        results.valid = false;
+                        results.error_message = "DEADLOCK: all threads are idle but the dispatcher is not empty";
+                    }
+                    break;
+                }
+            }
+
+            // a streaming run is one simulation, its scheduler time is a single sample
+            results.timing = Timing_stats::summarize({results.duration_ms});
+
+            if (results.valid) {
+                results.latency_ms = now;
+                results.runtime_est_ms = now - std::max(0.0, first_dispatch);
+            } else {
+                results.latency_ms = 0.0;
+                results.runtime_est_ms = 0.0;
+            }
+
+            trace.add_property("schedulerName", fn_name);
+            trace.add_property("estimatedRuntimeMs", results.runtime_est_ms);
+            trace.add_property("schedulerTimeMs", results.duration_ms);
+            trace.add_property("latencyMs", results.latency_ms);
+            trace.add_property("retiredTransactons", results.transactions_retired);
+            results.dispatches = t_id;
+            trace.add_property("dispatches", results.dispatches);
+
+            if (!results.valid) {
+                trace.add_property("valid", false);
+                trace.add_property("errorMessage", results.error_message.c_str());
+            }
+
+            config.emit_properties([&](char const *k, char const *v) {
+                trace.add_property(k, v);
+            });
+
+            trace.close();
+        }
+
+        if (config.real_threads && results.valid) {
+            util::output() << boost::format {"Executing[%s]\n"} % fn_name;
+            auto executed = Executor::execute_streaming(streaming.create(workload.transactions.size()), workload.transactions, workload.costs, config.thread_count, config.arrival_interval_ms, std::max(1u, config.arrival_batch));
+            if (executed.valid) {
+                results.runtime_measured_ms = executed.runtime_ms;
+            } else {
+                results.valid = false;
+                results.error_message = executed.error_message;
+            }
+
+            util::output()
+                << boost::format {"  End-to-end Wall Clock: %0.03fms (%0.03fms estimated), Retired: %d\n"}
+                % executed.runtime_ms
+                % results.latency_ms
+                % executed.transactions_retired;
+        }
+
+        return results;
+    }
+
     template<typename SCHED_FN>
-    static std::vector<Results> execute_all(std::vector<Transaction> const &transactions, std::map<Transaction::Id, double> const &costs, std::map<Transaction::Id, Transaction const *> const &tx_by_id, Config const &config, char const *fn_name, SCHED_FN fn) {
-        return std::vector<Results>({execute_one(transactions, costs, tx_by_id, config, fn_name, fn)});
+    static std::vector<Results> execute_all(Workload const &workload, Config const &config, char const *fn_name, SCHED_FN fn) {
+        return std::vector<Results>({execute_one(workload, config, fn_name, fn)});
     }
 
     template<typename SCHED_FN, typename ...ARGS >
-    static std::vector<Results> execute_all(std::vector<Transaction> const &transactions, std::map<Transaction::Id, double> const &costs, std::map<Transaction::Id, Transaction const *> const &tx_by_id, Config const &config, char const *fn_name, SCHED_FN fn, ARGS... args) {
-        std::vector<Results> results = execute_all(transactions, costs, tx_by_id, config, args...);
-        results.push_back(execute_one(transactions, costs, tx_by_id, config, fn_name, fn));
+    static std::vector<Results> execute_all(Workload const &workload, Config const &config, char const *fn_name, SCHED_FN fn, ARGS... args) {
+        std::vector<Results> results = execute_all(workload, config, args...);
+        results.push_back(execute_one(workload, config, fn_name, fn));
         return results;
     }
 
     template<typename ...ARGS >
-    static std::vector<Results> execute( Config const &config, ARGS... args) {
+    static std::vector<Results> execute( Config const &config, Workload const &workload, ARGS... args) {
         SCOPE_PROFILE("MAIN EXECUTE");
-        std::cout 
+        util::output() 
             << "Config:\n"
             << "  Generation:\n"
-            << boost::format {"    Transaction Count: %d\n"} % config.transaction_count
-            << boost::format {"    Scope Popularity: %0.04f avg (%0.04f std dev)\n"} % config.account_popularity_mean % config.account_popularity_stddev
-            << boost::format {"    Scope Degree Distribution:\n"};
-
-        for (uint degree = 0; degree< config.pct_transactions_per_scope_count.size(); degree++) {
-            std::cout << boost::format { "      %d: %0.04f\n" } % (degree + 1) % config.pct_transactions_per_scope_count[degree];
+            << boost::format {"    Transaction Count: %d\n"} % workload.transactions.size()
+            << boost::format {"    Seed: %d\n"} % workload.seed;
+
+        if (!config.load_workload_path.empty()) {
+            // the generation parameters on the command line do not describe a loaded workload
+            util::output() << boost::format {"    Loaded From: %s\n"} % config.load_workload_path;
+        } else if (!config.import_trace_path.empty()) {
+            util::output() << boost::format {"    Imported From: %s\n"} % config.import_trace_path;
+        } else {
+            util::output()
+                << boost::format {"    Scope Popularity: %0.04f avg (%0.04f std dev)\n"} % config.account_popularity_mean % config.account_popularity_stddev
+                << boost::format {"    Read Fraction: %0.04f\n"} % config.read_fraction
+                << boost::format {"    Scope Degree Distribution:\n"};
+
+            for (uint degree = 0; degree< config.pct_transactions_per_scope_count.size(); degree++) {
+                util::output() << boost::format { "      %d: %0.04f\n" } % (degree + 1) % config.pct_transactions_per_scope_count[degree];
+            }
         }
 
-        std::cout
+        util::output()
             << "  Analysis:\n"
             << boost::format {"    Simulated Thread Count: %d\n"} % config.thread_count
-            << boost::format {"    Transaction Cost: %0.04f avg (%0.04f std dev)\n"} % config.transaction_cost_ms_mean % config.transaction_cost_ms_stddev;
+            << boost::format {"    Scheduler Runs: %d timed after %d warmup\n"} % config.repeat % config.warmup
+            << boost::format {"    Arrivals: %d transactions every %0.04fms\n"} % config.arrival_batch % config.arrival_interval_ms
+            << boost::format {"    Real Threads: %s%s\n"} % (config.real_threads ? "yes" : "no") % (config.real_threads && config.work_stealing ? " (work-stealing)" : "")
+            << boost::format {"    Transaction Cost: %0.04f avg (%0.04f std dev)\n"} % config.transaction_cost_ms_mean % config.transaction_cost_ms_stddev
+            << boost::format {"    Dispatch Overheads: %0.04fms latency, %0.04fms next, %0.04fms finalize, %0.04fms barrier%s\n"}
+                % config.dispatch_latency_ms % config.next_cost_ms % config.finalize_cost_ms % config.barrier_cost_ms
+                % (config.serialize_dispatcher ? " (serialized)" : "");
+
+        auto const bounds = lower_bounds(workload, config.thread_count);
+        auto const arrival_bounds = arrival_lower_bounds(workload, config);
+        util::output()
+            << "  Lower Bounds:\n"
+            << boost::format {"    Critical Path: %0.03fms\n"} % bounds.critical_path_ms
+            << boost::format {"    Work / Threads: %0.03fms\n"} % bounds.work_ms
+            << boost::format {"    After Arrivals: %0.03fms\n"} % arrival_bounds.bound_ms();
+
+        util::output() << "=====================================\n";
+
+        // execute all schedulers
+        auto results = execute_all(workload, config, args...);
+        std::reverse(results.begin(), results.end());
+        for (auto &r: results) {
+            r.lower_bound_ms = r.streaming ? arrival_bounds.bound_ms() : bounds.bound_ms();
+            double runtime_ms = r.streaming ? r.latency_ms : r.runtime_est_ms;
+            r.efficiency_pct = (r.valid && runtime_ms > 0.0) ? 100.0 * r.lower_bound_ms / runtime_ms : 0.0;
+        }
+        return results;
+    }
 
-        std::cout << "=====================================\n";
+    /**
+     * time a parallel scheduler of the form fn(transactions, thread_count) on the workload using 1, 2, 4 ...
+     * host_thread_count threads
+     */
+    template<typename SCHED_FN>
+    static std::vector<Scaling_results> measure_scaling(Config const &config, Workload const &workload, char const *fn_name, SCHED_FN fn) {
+        SCOPE_PROFILE("Measure Scaling:", fn_name);
+        auto const &transactions = workload.transactions;
 
-        config.emit_properties(util::scope_profile::add_metadata);
-        
-       auto init_map = [](std::vector<Transaction> const &transactions){
-            SCOPE_PROFILE("Map Transactions By ID");
-            // create a map of id -> transaction
-            std::map<Transaction::Id, Transaction const *> transactions_by_id;
-            
-            // create per-account buckets of transaction Ids
-            for (auto const &t: transactions) {
-                transactions_by_id.emplace(t.id, &t);
-            }
+        std::vector<uint> thread_counts;
+        for (uint threads = 1; threads < config.host_thread_count; threads *= 2) {
+            thread_counts.push_back(threads);
+        }
+        thread_counts.push_back(std::max(1u, config.host_thread_count));
 
-            return transactions_by_id;
-        };
+        std::vector<Scaling_results> results;
+        for (auto const &threads: thread_counts) {
+            util::output() << boost::format {"Scaling[%s] with %d threads\n"} % fn_name % threads;
+            SCOPE_PROFILE("Schedule:", threads);
+            auto sched_start = std::chrono::steady_clock::now();
+            auto const block = fn(transactions, threads);
+            auto sched_end = std::chrono::steady_clock::now();
+            results.push_back(Scaling_results {threads, (std::chrono::duration_cast<std::chrono::duration<double, std::ratio<1, 1000>>>(sched_end - sched_start)).count()});
+        }
 
-        // generate transactions
-        auto const transactions = generate_transactions(config);
-        auto const costs = generate_costs(transactions, config);
-        auto const transactions_by_id = init_map(transactions);
-        
-        // execute all schedulers
-        auto results = execute_all(transactions, costs, transactions_by_id, config, args...);
-        std::reverse(results.begin(), results.end());
         return results;
     }
 };
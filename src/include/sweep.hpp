@@ -0,0 +1,56 @@
+#pragma once
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+#include "runner.hpp"
+
+namespace sched_bench {
+
+/**
+ * A grid of Runner::Config points built from one or more axes, each a config field and the values it takes.  Every
+ * combination of values is a point, the first axis varies slowest.  Axes are given as "field=values" where values are
+ *
+ *   a,b,c                  a list
+ *   start:stop[:step]      start, start + step ... up to and including stop, the step defaults to 1
+ *   start:stop:*factor     start, start * factor ... up to and including stop
+ *
+ * except for scope-distribution, whose values are comma separated distributions separated by ';'.
+ */
+struct Sweep {
+    struct Axis {
+        std::string field;
+        std::vector<std::string> values;
+    };
+
+    // one scheduler result at one point, with the point's config properties in emit_properties order
+    struct Row {
+        uint point;
+        std::vector<std::pair<std::string, std::string>> properties;
+        Runner::Results results;
+    };
+
+    typedef std::function<std::vector<Runner::Results> (Runner::Config const &, Runner::Workload const &)> Run_fn;
+
+    // print the reason and return false for unknown fields or malformed values
+    bool add_axis(std::string const &spec);
+
+    std::vector<Runner::Config> points(Runner::Config const &base) const;
+
+    /**
+     * generate the workload and run every scheduler at every point, using up to thread_count points at a time.  The
+     * base config's host threads are split evenly between the points running at the same time.  Points that fail to
+     * prepare a workload are reported and skipped.
+     */
+    std::vector<Row> run(Runner::Config const &base, uint thread_count, Run_fn const &run_fn) const;
+
+    // the fields that can be swept, by their command line names
+    static std::vector<char const *> fields();
+
+    // write the rows as CSV, or JSON when the filename ends in .json
+    static bool write(std::vector<Row> const &rows, std::string const &filename);
+
+    std::vector<Axis> axes;
+};
+
+}
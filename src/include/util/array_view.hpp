@@ -0,0 +1,51 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+namespace sched_bench { namespace util {
+
+/**
+ * A non-owning, read-only view of a contiguous array.  The storage must outlive the view, this is how transactions
+ * reference their accounts in a pool owned by the workload, which may be a memory-mapped file.
+ */
+template<typename T>
+class Array_view {
+public:
+    typedef T value_type;
+    typedef T const *iterator;
+    typedef T const *const_iterator;
+
+    Array_view()
+        : _data(nullptr)
+        , _size(0)
+    {
+    }
+
+    Array_view(T const *data, std::size_t size)
+        : _data(data)
+        , _size(size)
+    {
+    }
+
+    Array_view(std::vector<T> const &vec)
+        : _data(vec.data())
+        , _size(vec.size())
+    {
+    }
+
+    T const *begin() const { return _data; }
+    T const *end() const { return _data + _size; }
+    T const *data() const { return _data; }
+    std::size_t size() const { return _size; }
+    bool empty() const { return _size == 0; }
+
+    T const &operator[](std::size_t index) const {
+        return _data[index];
+    }
+
+private:
+    T const *_data;
+    std::size_t _size;
+};
+
+}}
@@ -1,4 +1,7 @@
 #pragma once
+#include <iterator>
+#include <type_traits>
+#include <vector>
 
 
 namespace sched_bench { namespace util {
@@ -0,0 +1,37 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <string>
+
+namespace sched_bench { namespace util {
+
+/**
+ * A read-only memory mapping of a whole file, unmapped on destruction.  Where mmap is not available the file is read
+ * into memory instead.
+ */
+class Mapped_file {
+public:
+    // returns nullptr if the file cannot be opened or mapped
+    static std::unique_ptr<Mapped_file> open(std::string const &filename);
+    ~Mapped_file();
+
+    Mapped_file(Mapped_file const &) = delete;
+    Mapped_file& operator= (Mapped_file const &) = delete;
+
+    char const *data() const {
+        return _data;
+    }
+
+    std::size_t size() const {
+        return _size;
+    }
+
+private:
+    Mapped_file(char const *data, std::size_t size, bool mapped);
+
+    char const *_data;
+    std::size_t _size;
+    bool _mapped;
+};
+
+}}
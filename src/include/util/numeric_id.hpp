@@ -1,4 +1,5 @@
 #pragma once
+#include <cstdint>
 
 namespace sched_bench { namespace util {
 
@@ -0,0 +1,41 @@
+#pragma once
+#include <iostream>
+
+namespace sched_bench { namespace util {
+
+inline
+std::ostream *&thread_output() {
+    thread_local std::ostream *stream = &std::cout;
+    return stream;
+}
+
+/**
+ * where the runner, the workload sources and the schedulers report their progress, std::cout unless the calling thread
+ * redirected it.  Sweep points run in parallel and each sends its own reports elsewhere, std::cout is never touched.
+ */
+inline
+std::ostream &output() {
+    return *thread_output();
+}
+
+/**
+ * send the calling thread's output to a sink until destroyed
+ */
+struct Redirect_output {
+    explicit Redirect_output(std::ostream &sink)
+        : previous(thread_output())
+    {
+        thread_output() = &sink;
+    }
+
+    ~Redirect_output() {
+        thread_output() = previous;
+    }
+
+    Redirect_output(Redirect_output const &) = delete;
+    Redirect_output& operator= (Redirect_output const &) = delete;
+
+    std::ostream *previous;
+};
+
+}}
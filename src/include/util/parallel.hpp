@@ -0,0 +1,50 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace sched_bench { namespace util {
+
+/**
+ * the number of threads to use for host-side parallel work when the user does not specify one
+ */
+inline
+uint default_host_thread_count() {
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+/**
+ * call op(index) for every index in [0, count) using up to thread_count threads (including the calling thread)
+ * indices are handed out dynamically so uneven work is balanced across threads
+ */
+template<typename OP>
+void parallel_for(uint count, uint thread_count, OP op) {
+    thread_count = std::max(1u, std::min(thread_count, count));
+    if (thread_count == 1) {
+        for (uint index = 0; index < count; index++) {
+            op(index);
+        }
+        return;
+    }
+
+    std::atomic_uint next_index(0);
+    auto worker = [&]() {
+        for (uint index = next_index.fetch_add(1); index < count; index = next_index.fetch_add(1)) {
+            op(index);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(thread_count - 1);
+    for (uint t = 1; t < thread_count; t++) {
+        threads.emplace_back(worker);
+    }
+
+    worker();
+    for (auto &t: threads) {
+        t.join();
+    }
+}
+
+}}
@@ -0,0 +1,77 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace sched_bench { namespace util { namespace scope_profile {
+
+enum class Sample_record_type : uint8_t {
+    INVALID,
+    BEGIN,
+    END,
+};
+
+enum class Sample_arg_type : uint8_t {
+    NONE,
+    INT,
+    DOUBLE,
+    STRING,
+};
+
+/**
+ * A single profile sample.  The scope name is an interned id and up to MAX_ARGS arguments are stored unformatted, the
+ * type of each argument is packed into arg_types (4 bits per argument).  Doubles are stored bitwise and strings as
+ * interned ids.
+ */
+struct Sample_record {
+    static const uint MAX_ARGS = 2;
+
+    uint64_t ticks;
+    uint32_t tid;
+    uint16_t name_id;
+    Sample_record_type type;
+    uint8_t arg_types;
+    int64_t args[MAX_ARGS];
+
+    Sample_arg_type arg_type(uint index) const {
+        return static_cast<Sample_arg_type>((arg_types >> (index * 4)) & 0xF);
+    }
+};
+
+static_assert(sizeof(Sample_record) == 32, "unexpected size of struct Sample_record");
+
+/**
+ * Everything needed to render a profile.  The compact binary file ("SBPROF01") is laid out as:
+ *
+ *   char[8] magic, u32 version, f64 ticks_per_us, u64 epoch_ticks, i64 start_time, i64 end_time, u64 dropped_samples
+ *   u32 name_count, { u32 length, char[length] } names
+ *   u32 metadata_count, { u32 length, char[length] key, u32 length, char[length] value } metadata
+ *   u64 record_count, Sample_record[record_count]
+ */
+struct Profile {
+    static const uint32_t VERSION = 1;
+
+    double ticks_per_us;
+    uint64_t epoch_ticks;
+    std::time_t start_time;
+    std::time_t end_time;
+    uint64_t dropped_samples;
+    std::vector<std::string> names;
+    std::vector<std::pair<std::string, std::string>> metadata;
+    std::vector<Sample_record> records;
+
+    // the scope name with its arguments appended, as the original SCOPE_PROFILE arguments would have printed it
+    std::string record_name(Sample_record const &record) const;
+    uint64_t record_time_us(Sample_record const &record) const;
+};
+
+bool write_binary(std::FILE *file, Profile const &profile);
+bool read_binary(std::FILE *file, Profile &profile);
+void write_chrome_json(std::ostream &out, Profile const &profile);
+void write_perfetto(std::ostream &out, Profile const &profile);
+
+}}}
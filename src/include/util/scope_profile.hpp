@@ -1,78 +1,117 @@
 #pragma once
-#include <algorithm>
 #include <chrono>
-#include <cstdio>
+#include <cstdint>
+#include <cstring>
 #include <thread>
+#include "util/profile_format.hpp"
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define SCOPE_PROFILE_HAS_RDTSC 1
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define SCOPE_PROFILE_HAS_RDTSC 1
+#endif
 
 namespace sched_bench { namespace util {
 
     namespace scope_profile {
-        enum class Sample_record_type {
-            INVALID,
-            BEGIN,
-            END,
+        enum class Format {
+            JSON,       // Chrome trace event JSON, written at shutdown
+            BINARY,     // the compact record file, convert it offline with profile_convert
         };
 
-        struct Sample_record_header {
-            std::chrono::steady_clock::time_point tp;
-            uint tid;
-            Sample_record_type type;
-        };
+        /**
+         * Every instrumented thread owns a single-producer/single-consumer ring of num_sample_records records that the
+         * output thread drains.  If a ring is full the sample is dropped and counted rather than stalling the thread.
+         */
+        bool init(char const *filename, uint num_sample_records = 4096, Format format = Format::JSON);
+        void add_metadata(char const *key, char const *value);
+        uint get_thread_id();
+        void shutdown();
 
-        struct Sample_record : public Sample_record_header {
-            static const uint DESIRED_RECORD_SIZE = 256;
-            static const uint MAX_NAME_LENGTH = DESIRED_RECORD_SIZE - sizeof(Sample_record_header);
-            char name[MAX_NAME_LENGTH];
-        };
+        // returns nullptr if the sample should be dropped, otherwise the record must be published with commit_record
+        Sample_record *acquire_record(Sample_record_type type);
+        void commit_record();
 
-        static_assert(sizeof(Sample_record) == Sample_record::DESIRED_RECORD_SIZE, "unexpected size of struct Sample_record");
+        // scope names are interned once per SCOPE_PROFILE site
+        uint16_t intern_name(char const *name);
 
-        bool init(char const *filename, uint num_sample_record = 4096);
-        void add_metadata(char const *key, char const *value);
-        uint get_thread_id();
-        Sample_record &get_record();
-        void shutdown();        
+        // string arguments are interned on every sample, this is cached per thread by address and checked by content
+        uint16_t intern_string_arg(char const *value);
 
-        template<typename ARG>
-        struct __format_string {
-        };
+        // the cycle counter where available, it is calibrated against steady_clock when the profile is written
+        inline uint64_t read_ticks() {
+#ifdef SCOPE_PROFILE_HAS_RDTSC
+            return __rdtsc();
+#else
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+        }
 
-        template<typename ARG>
-        void record_sample_name(char *buf, uint &offset, uint capacity, ARG arg) {
-            if (capacity - offset < 1) {
-                return;
+        struct Site {
+            explicit Site(char const *name)
+                : name_id(intern_name(name))
+            {
             }
-            offset = std::min(capacity, offset + std::snprintf(buf+offset, capacity-offset, __format_string<ARG>::value, arg));
+
+            uint16_t const name_id;
+        };
+
+        inline Sample_arg_type encode_arg(int64_t &slot, int arg) { slot = arg; return Sample_arg_type::INT; }
+        inline Sample_arg_type encode_arg(int64_t &slot, uint arg) { slot = arg; return Sample_arg_type::INT; }
+        inline Sample_arg_type encode_arg(int64_t &slot, long arg) { slot = arg; return Sample_arg_type::INT; }
+        inline Sample_arg_type encode_arg(int64_t &slot, unsigned long arg) { slot = arg; return Sample_arg_type::INT; }
+        inline Sample_arg_type encode_arg(int64_t &slot, long long arg) { slot = arg; return Sample_arg_type::INT; }
+        inline Sample_arg_type encode_arg(int64_t &slot, unsigned long long arg) { slot = arg; return Sample_arg_type::INT; }
+
+        inline Sample_arg_type encode_arg(int64_t &slot, double arg) {
+            std::memcpy(&slot, &arg, sizeof(slot));
+            return Sample_arg_type::DOUBLE;
         }
 
+        inline Sample_arg_type encode_arg(int64_t &slot, float arg) { return encode_arg(slot, static_cast<double>(arg)); }
+        inline Sample_arg_type encode_arg(int64_t &slot, char const *arg) { slot = intern_string_arg(arg); return Sample_arg_type::STRING; }
+
+        inline
+        void record_sample_args(Sample_record &, uint) {
+        }
+
+        // arguments past Sample_record::MAX_ARGS are ignored
         template<typename ARG, typename ...ARGS>
-        void record_sample_name(char *buf, uint &offset, uint capacity, ARG arg, ARGS... args) {
-            record_sample_name(buf, offset, capacity, arg);
-            record_sample_name(buf, offset, capacity, args...);
+        void record_sample_args(Sample_record &record, uint index, ARG arg, ARGS... args) {
+            if (index >= Sample_record::MAX_ARGS) {
+                return;
+            }
+            record.arg_types |= static_cast<uint8_t>(encode_arg(record.args[index], arg)) << (index * 4);
+            record_sample_args(record, index + 1, args...);
         }
 
         template<typename ...ARGS>
-        void emit_sample_begin(ARGS... args) {
-            auto now = std::chrono::steady_clock::now();
-            auto tid = get_thread_id();
-            auto &record = get_record();
-            
-            uint offset = 0;
-            record_sample_name(record.name, offset, Sample_record::MAX_NAME_LENGTH, args...);
-            
-            record.tp = now;
-            record.tid = tid;
-            record.type = Sample_record_type::BEGIN;
+        void emit_sample_begin(Site const &site, ARGS... args) {
+            auto now = read_ticks();
+            auto *record = acquire_record(Sample_record_type::BEGIN);
+            if (record == nullptr) {
+                return;
+            }
+
+            record->name_id = site.name_id;
+            record->arg_types = 0;
+            record_sample_args(*record, 0, args...);
+            record->ticks = now;
+            commit_record();
         }
 
         inline
         void emit_sample_end() {
-            auto tid = get_thread_id();
-            auto &record = get_record();
-            auto now = std::chrono::steady_clock::now();
-            record.tp = now;
-            record.tid = tid;
-            record.type = Sample_record_type::END;
+            auto *record = acquire_record(Sample_record_type::END);
+            if (record == nullptr) {
+                return;
+            }
+
+            record->arg_types = 0;
+            record->ticks = read_ticks();
+            commit_record();
         }
 
         class Sample {
@@ -81,54 +120,30 @@ namespace sched_bench { namespace util {
                     emit_sample_end();
                 }
 
-                template<typename ...ARGS>
-                static Sample create(ARGS... args) {
-                    emit_sample_begin(args...);
+                // the first argument is the site's name, it was interned when the site was initialized
+                template<typename NAME, typename ...ARGS>
+                static Sample create(Site const &site, NAME, ARGS... args) {
+                    emit_sample_begin(site, args...);
                     return Sample();
                 }
 
             protected:
                 Sample() {};
-    
+
         };
 
         #define MERGE_TOKENS(a,b)  a##b
         #define LABEL_SAMPLE(a) MERGE_TOKENS(__scope_profile_sample_, a)
+        #define LABEL_SITE(a) MERGE_TOKENS(__scope_profile_site_, a)
         #define UNIQUE_SAMPLE LABEL_SAMPLE(__COUNTER__)
 
-        #define SCOPE_PROFILE(...) auto UNIQUE_SCOPE = ::sched_bench::util::scope_profile::Sample::create(__VA_ARGS__)
-        #define SCOPE_PROFILE_FUNCTION() auto UNIQUE_SCOPE = ::sched_bench::util::scope_profile::Sample::create(__FUNCTION__)
-        
-
-        template<>
-        struct __format_string<char const *> {
-            static constexpr char const * value = "%s";
-        };
+        #define SCOPE_PROFILE_FIRST_ARG(first, ...) first
+        #define SCOPE_PROFILE_AT(id, ...) \
+            static ::sched_bench::util::scope_profile::Site const LABEL_SITE(id) (SCOPE_PROFILE_FIRST_ARG(__VA_ARGS__, "")); \
+            auto LABEL_SAMPLE(id) = ::sched_bench::util::scope_profile::Sample::create(LABEL_SITE(id), __VA_ARGS__)
 
-        template<>
-        struct __format_string<char *> {
-            static constexpr char const * value = "%s";
-        };
-
-        template<>
-        struct __format_string<uint> {
-            static constexpr char const * value = "%d";
-        };
-
-        template<>
-        struct __format_string<int> {
-            static constexpr char const * value = "%d";
-        };
-
-        template<>
-        struct __format_string<float> {
-            static constexpr char const * value = "%0.04f";
-        };
-
-        template<>
-        struct __format_string<double> {
-            static constexpr char const * value = "%0.04f";
-        };
+        #define SCOPE_PROFILE(...) SCOPE_PROFILE_AT(__COUNTER__, __VA_ARGS__)
+        #define SCOPE_PROFILE_FUNCTION() SCOPE_PROFILE(__FUNCTION__)
     }
 
-}}
\ No newline at end of file
+}}
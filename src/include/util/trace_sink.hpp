@@ -0,0 +1,205 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace sched_bench { namespace util {
+
+/**
+ * Buffered writer for the per-scheduler execution traces.
+ *
+ * Events are formatted into large reusable buffers on the calling thread and full buffers are written to disk by a
+ * background thread, so emitting an event costs a few hundred nanoseconds at most.  The formats are:
+ *
+ *  JSON   - Chrome trace event JSON, the events followed by the run properties as top level keys
+ *  BINARY - "SBTRACE1" followed by little-endian records:
+ *             u8 1 (begin), u32 thread, i64 ts_us, u32 dispatch, u32 count, u32 transaction_ids[count]
+ *             u8 2 (end),   u32 thread, i64 ts_us
+ *             u8 3 (property), u32 key_length, key, u32 value_length, value
+ *  NONE   - nothing is written
+ */
+class Trace_sink {
+public:
+    enum class Format {
+        NONE,
+        JSON,
+        BINARY,
+    };
+
+    static bool parse_format(std::string const &name, Format &format);
+    static char const *format_name(Format format);
+    static char const *extension(Format format);
+
+    Trace_sink(std::string const &basename, Format format, uint buffer_size = 1 << 20, uint buffer_count = 4);
+    ~Trace_sink();
+
+    Trace_sink(Trace_sink const &) = delete;
+    Trace_sink& operator= (Trace_sink const &) = delete;
+
+    template<typename IDS>
+    void begin(uint thread_id, int64_t ts_us, uint dispatch_id, IDS const &ids) {
+        if (format == Format::JSON) {
+            reserve(128);
+            write_event_separator();
+            write_literal("{\"tid\":");
+            write_uint(thread_id);
+            write_literal(",\"pid\":");
+            write_uint(thread_id);
+            write_literal(",\"ts\":");
+            write_int(ts_us);
+            write_literal(",\"ph\":\"B\",\"cat\":\"T\",\"name\":\"D:");
+            write_uint(dispatch_id);
+            write_literal("\",\"args\":{\"txs\":[");
+            bool first = true;
+            for (auto const &id: ids) {
+                reserve(16);
+                if (!first) {
+                    write_char(',');
+                }
+                write_uint(id.as_numeric());
+                first = false;
+            }
+            reserve(8);
+            write_literal("]}}");
+        } else if (format == Format::BINARY) {
+            reserve(1 + 4 + 8 + 4 + 4);
+            write_raw<uint8_t>(1);
+            write_raw<uint32_t>(thread_id);
+            write_raw<int64_t>(ts_us);
+            write_raw<uint32_t>(dispatch_id);
+            write_raw<uint32_t>(ids.size());
+            for (auto const &id: ids) {
+                reserve(4);
+                write_raw<uint32_t>(id.as_numeric());
+            }
+        }
+    }
+
+    void end(uint thread_id, int64_t ts_us) {
+        if (format == Format::JSON) {
+            reserve(96);
+            write_event_separator();
+            write_literal("{\"tid\":");
+            write_uint(thread_id);
+            write_literal(",\"pid\":");
+            write_uint(thread_id);
+            write_literal(",\"ts\":");
+            write_int(ts_us);
+            write_literal(",\"ph\":\"E\"}");
+        } else if (format == Format::BINARY) {
+            reserve(1 + 4 + 8);
+            write_raw<uint8_t>(2);
+            write_raw<uint32_t>(thread_id);
+            write_raw<int64_t>(ts_us);
+        }
+    }
+
+    // properties are written after all of the events, adding one ends the event list
+    void add_property(char const *key, char const *value);
+    void add_property(char const *key, double value);
+    void add_property(char const *key, uint value);
+    void add_property(char const *key, bool value);
+
+    // flush everything and wait for the background writer to finish
+    void close();
+
+private:
+    struct Buffer {
+        std::unique_ptr<char[]> data;
+        uint size;
+    };
+
+    void reserve(uint bytes) {
+        if (current->size + bytes > buffer_size) {
+            swap_buffers();
+        }
+    }
+
+    void write_char(char c) {
+        current->data[current->size++] = c;
+    }
+
+    template<std::size_t N>
+    void write_literal(char const (&str)[N]) {
+        std::memcpy(current->data.get() + current->size, str, N - 1);
+        current->size += N - 1;
+    }
+
+    template<typename T>
+    void write_raw(T value) {
+        std::memcpy(current->data.get() + current->size, &value, sizeof(T));
+        current->size += sizeof(T);
+    }
+
+    void write_uint(uint64_t value) {
+        static char const digit_pairs[201] =
+            "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+            "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+            "8081828384858687888990919293949596979899";
+        char digits[20];
+        char *pos = digits + sizeof(digits);
+        while (value >= 100) {
+            uint pair = (value % 100) * 2;
+            value /= 100;
+            *--pos = digit_pairs[pair + 1];
+            *--pos = digit_pairs[pair];
+        }
+        if (value >= 10) {
+            uint pair = value * 2;
+            *--pos = digit_pairs[pair + 1];
+            *--pos = digit_pairs[pair];
+        } else {
+            *--pos = '0' + value;
+        }
+        uint length = digits + sizeof(digits) - pos;
+        std::memcpy(current->data.get() + current->size, pos, length);
+        current->size += length;
+    }
+
+    void write_int(int64_t value) {
+        if (value < 0) {
+            write_char('-');
+            write_uint(0 - static_cast<uint64_t>(value));
+        } else {
+            write_uint(value);
+        }
+    }
+
+    void write_event_separator() {
+        if (events_written) {
+            write_literal(",\n");
+        }
+        events_written = true;
+    }
+
+    void write_string(char const *str, uint length);
+    void write_property(char const *key, char const *value, bool quoted);
+    void swap_buffers();
+    void writer_entry();
+
+    Format format;
+    uint buffer_size;
+    std::FILE *file;
+    bool events_written;
+    bool properties_written;
+    bool closed;
+
+    std::vector<Buffer> buffers;
+    Buffer *current;
+    std::deque<Buffer *> full_buffers;
+    std::vector<Buffer *> free_buffers;
+    std::mutex mutex;
+    std::condition_variable writer_wakeup;
+    std::condition_variable producer_wakeup;
+    bool closing;
+    std::thread writer;
+};
+
+}}
@@ -0,0 +1,127 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace sched_bench { namespace util {
+
+/**
+ * Chase-Lev work-stealing deque following "Correct and Efficient Work-Stealing for Weak Memory Models" (Le et al.)
+ *
+ * The owning thread pushes and pops at the bottom, any other thread may steal from the top.  The buffer grows as
+ * needed, retired buffers are kept alive until the deque is destroyed because thieves may still be reading them.
+ */
+template<typename T>
+class Work_stealing_deque {
+public:
+    explicit Work_stealing_deque(int64_t initial_capacity = 1024)
+        : top(0)
+        , bottom(0)
+    {
+        int64_t capacity = 1;
+        while (capacity < initial_capacity) {
+            capacity <<= 1;
+        }
+        buffers.emplace_back(new Buffer(capacity));
+        buffer.store(buffers.back().get(), std::memory_order_relaxed);
+    }
+
+    Work_stealing_deque(Work_stealing_deque const &) = delete;
+    Work_stealing_deque& operator= (Work_stealing_deque const &) = delete;
+
+    // owner only
+    void push(T value) {
+        int64_t b = bottom.load(std::memory_order_relaxed);
+        int64_t t = top.load(std::memory_order_acquire);
+        Buffer *a = buffer.load(std::memory_order_relaxed);
+        if (b - t > a->capacity - 1) {
+            buffers.emplace_back(a->grow(b, t));
+            a = buffers.back().get();
+            buffer.store(a, std::memory_order_release);
+        }
+        a->put(b, value);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom.store(b + 1, std::memory_order_relaxed);
+    }
+
+    // owner only
+    bool pop(T &value) {
+        int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+        Buffer *a = buffer.load(std::memory_order_relaxed);
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = top.load(std::memory_order_relaxed);
+        if (t > b) {
+            // empty
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return false;
+        }
+
+        value = a->get(b);
+        if (t == b) {
+            // last element, race any thieves for it
+            bool won = top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return won;
+        }
+
+        return true;
+    }
+
+    // any thread, may spuriously fail when racing another thief or the owner
+    bool steal(T &value) {
+        int64_t t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = bottom.load(std::memory_order_acquire);
+        if (t >= b) {
+            return false;
+        }
+
+        Buffer *a = buffer.load(std::memory_order_acquire);
+        value = a->get(t);
+        return top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+    }
+
+    bool empty() const {
+        return bottom.load(std::memory_order_relaxed) <= top.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct Buffer {
+        explicit Buffer(int64_t _capacity)
+            : capacity(_capacity)
+            , values(new std::atomic<T>[_capacity])
+        {
+        }
+
+        T get(int64_t index) const {
+            return values[index & (capacity - 1)].load(std::memory_order_relaxed);
+        }
+
+        void put(int64_t index, T value) {
+            values[index & (capacity - 1)].store(value, std::memory_order_relaxed);
+        }
+
+        Buffer *grow(int64_t b, int64_t t) const {
+            Buffer *result = new Buffer(capacity * 2);
+            for (int64_t i = t; i < b; i++) {
+                result->put(i, get(i));
+            }
+            return result;
+        }
+
+        int64_t capacity;
+        std::unique_ptr<std::atomic<T>[]> values;
+    };
+
+    // keep top and bottom on separate cache lines, thieves hammer top while the owner works at the bottom
+    std::atomic<int64_t> top;
+    char top_padding[64 - sizeof(std::atomic<int64_t>)];
+    std::atomic<int64_t> bottom;
+    char bottom_padding[64 - sizeof(std::atomic<int64_t>)];
+    std::atomic<Buffer *> buffer;
+    std::vector<std::unique_ptr<Buffer>> buffers;
+};
+
+}}
@@ -2,31 +2,77 @@
 #include <boost/program_options.hpp>
 #include <iostream>
 #include <iomanip>
+#include <random>
 
 #include "runner.hpp"
+#include "sweep.hpp"
 #include "algorithms/delay_conflicts.hpp"
 #include "algorithms/single_thread.hpp"
 #include "algorithms/graph.hpp"
+#include "algorithms/csr_graph.hpp"
+#include "algorithms/chain_fusion.hpp"
+#include "algorithms/list_schedule.hpp"
+#include "algorithms/component_partition.hpp"
+#include "algorithms/conflict_coloring.hpp"
+#include "algorithms/streaming.hpp"
 #include "util/functional.hpp"
+#include "util/parallel.hpp"
 #include "util/scope_profile.hpp"
 
 using namespace sched_bench;
 namespace po = boost::program_options;
 
-boost::optional<Runner::Config> parse_options(int argc, char *argv[]) {
-    boost::optional<Runner::Config> no_config;
+struct Options {
     Runner::Config config;
+    bool scheduler_scaling;
+    util::scope_profile::Format profile_format;
+    Sweep sweep;
+    std::string sweep_output;
+    uint sweep_threads;
+};
+
+boost::optional<Options> parse_options(int argc, char *argv[]) {
+    boost::optional<Options> no_config;
+    Options options;
+    Runner::Config &config = options.config;
     std::string scope_dist_str;
+    std::string trace_format_str;
+    std::string profile_format_str;
+    std::vector<std::string> sweep_strs;
 
     po::options_description desc("Options:");
     desc.add_options()
         ("help", "show this help message")
         ("transactions,t", po::value<uint>(&config.transaction_count)->default_value(1000), "The number of transactions to simulate")
+        ("seed", po::value<uint64_t>(&config.seed), "The seed for workload generation, a random seed is chosen and reported when omitted")
         ("threads,n", po::value<uint>(&config.thread_count)->default_value(20), "The number of threads to simulate during analysis")
+        ("real-threads", po::bool_switch(&config.real_threads), "Also execute each schedule on a pool of real threads that burn CPU for each transaction's cost")
         ("avg-cost",po::value<double>(&config.transaction_cost_ms_mean)->default_value(0.3), "The average cost of a transaction in milliseconds")
         ("stddev-cost",po::value<double>(&config.transaction_cost_ms_stddev)->default_value(0.25), "The standard-deviation cost of a transaction in milliseconds")
         ("avg-popularity",po::value<double>(&config.account_popularity_mean)->default_value(0.01), "The average percentage of transactions that a scope appears in")
         ("stddev-popularity",po::value<double>(&config.account_popularity_stddev)->default_value(0.005), "The standard-deviation percentage of transactions that a scope appears in")
+        ("read-fraction",po::value<double>(&config.read_fraction)->default_value(0.0), "The fraction of scope references that only read the scope, concurrent readers of a scope do not conflict")
+        ("fusion-max-cost",po::value<double>(&config.fusion_max_cost_ms)->default_value(1.0), "The most a fused chain of graph transactions may cost in milliseconds before it becomes another dispatch")
+        ("dispatch-latency",po::value<double>(&config.dispatch_latency_ms)->default_value(0.0), "Simulated milliseconds from handing out a dispatch to its thread starting on it")
+        ("next-cost",po::value<double>(&config.next_cost_ms)->default_value(0.0), "Simulated milliseconds the dispatcher spends handing out each dispatch")
+        ("finalize-cost",po::value<double>(&config.finalize_cost_ms)->default_value(0.0), "Simulated milliseconds the dispatcher spends finalizing each dispatch")
+        ("barrier-cost",po::value<double>(&config.barrier_cost_ms)->default_value(0.0), "Simulated milliseconds to release the threads waiting at a cycle barrier")
+        ("serialize-dispatcher", po::bool_switch(&config.serialize_dispatcher), "Simulate the dispatcher as a single-threaded resource whose calls queue up behind each other")
+        ("work-stealing", po::bool_switch(&config.work_stealing), "When executing on real threads, run dependency graphs with the work-stealing dispatcher")
+        ("arrival-interval",po::value<double>(&config.arrival_interval_ms)->default_value(0.0), "Milliseconds between arriving batches of transactions, streaming schedulers start before the block is complete")
+        ("arrival-batch",po::value<uint>(&config.arrival_batch)->default_value(64), "The number of transactions in each arriving batch")
+        ("repeat",po::value<uint>(&config.repeat)->default_value(1), "Time every scheduler this many times on the same workload and report the distribution")
+        ("warmup",po::value<uint>(&config.warmup)->default_value(0), "Untimed runs of every scheduler before the timed ones")
+        ("host-threads",po::value<uint>(&config.host_thread_count)->default_value(util::default_host_thread_count()), "The number of real threads parallel schedulers may use")
+        ("scheduler-scaling", po::bool_switch(&options.scheduler_scaling), "Also report how the parallel schedulers scale from 1 to host-threads threads")
+        ("save-workload",po::value<std::string>(&config.save_workload_path), "Save the workload to a snapshot file before running the schedulers")
+        ("load-workload",po::value<std::string>(&config.load_workload_path), "Run the schedulers on a workload snapshot instead of generating one")
+        ("import-trace",po::value<std::string>(&config.import_trace_path), "Run the schedulers on a recorded CSV or JSONL transaction trace instead of generating a workload")
+        ("trace-format",po::value<std::string>(&trace_format_str)->default_value("json"), "The format of the per-scheduler execution traces: json, binary or none")
+        ("profile-format",po::value<std::string>(&profile_format_str)->default_value("json"), "The format of the scope profile: json (profile.trace) or binary (profile.bin, convert it with profile_convert)")
+        ("sweep",po::value<std::vector<std::string>>(&sweep_strs)->composing(), "Run every scheduler at every point of a grid, e.g. --sweep transactions=1000:16000:*2 --sweep threads=4,8,16 (repeat for more axes)")
+        ("sweep-output",po::value<std::string>(&options.sweep_output)->default_value("sweep.csv"), "Where sweep results are written, as JSON if the name ends in .json and CSV otherwise")
+        ("sweep-threads",po::value<uint>(&options.sweep_threads)->default_value(util::default_host_thread_count()), "The number of sweep points run at the same time")
         ("scope-distribution",po::value<std::string>(&scope_dist_str)->default_value("0.1587,0.6827,0.1573,0.0013"), "a comma separated list defining what percentage of transactions reference that many scopes (as a one-based array)")
         ;
 
@@ -48,62 +94,313 @@ boost::optional<Runner::Config> parse_options(int argc, char *argv[]) {
         return no_config;
     }
 
+    if (!vm.count("seed")) {
+        std::random_device rdev;
+        config.seed = (static_cast<uint64_t>(rdev()) << 32) | rdev();
+    }
+
+    if (config.read_fraction < 0.0 || config.read_fraction > 1.0) {
+        std::cerr << "Error: the read fraction must be between 0 and 1\n";
+        return no_config;
+    }
+
+    if (config.dispatch_latency_ms < 0.0 || config.next_cost_ms < 0.0 || config.finalize_cost_ms < 0.0 || config.barrier_cost_ms < 0.0) {
+        std::cerr << "Error: dispatch overheads must not be negative\n";
+        return no_config;
+    }
+
+    if (config.repeat == 0) {
+        std::cerr << "Error: every scheduler must be timed at least once\n";
+        return no_config;
+    }
+
+    if (config.arrival_interval_ms < 0.0 || config.arrival_batch == 0) {
+        std::cerr << "Error: the arrival interval must not be negative and arrival batches must not be empty\n";
+        return no_config;
+    }
+
+    if (!util::Trace_sink::parse_format(trace_format_str, config.trace_format)) {
+        std::cerr << "Error: unknown trace format \"" << trace_format_str << "\"\n";
+        return no_config;
+    }
+
+    if (profile_format_str == "json") {
+        options.profile_format = util::scope_profile::Format::JSON;
+    } else if (profile_format_str == "binary") {
+        options.profile_format = util::scope_profile::Format::BINARY;
+    } else {
+        std::cerr << "Error: unknown profile format \"" << profile_format_str << "\"\n";
+        return no_config;
+    }
+
+    for (auto const &spec: sweep_strs) {
+        if (!options.sweep.add_axis(spec)) {
+            return no_config;
+        }
+    }
+
+    if (!options.sweep.axes.empty()) {
+        if (!config.save_workload_path.empty()) {
+            std::cerr << "Error: a sweep cannot save its workloads\n";
+            return no_config;
+        }
+
+        // points running side by side would burn CPU on the same cores they are timed on
+        if (config.real_threads && options.sweep_threads > 1) {
+            std::cerr << "Error: a sweep can only execute on real threads one point at a time, use --sweep-threads 1\n";
+            return no_config;
+        }
+
+        // every point would write the same trace files
+        config.trace_format = util::Trace_sink::Format::NONE;
+    }
+
     std::vector<std::string> scope_pct_strs;
     boost::split(scope_pct_strs, scope_dist_str, boost::is_any_of(","));
     config.pct_transactions_per_scope_count = util::map<>(scope_pct_strs, [](std::string const &str, uint index) -> double {
         return std::stod(str);
     });
 
-    return boost::optional<Runner::Config>(config);    
+    return boost::optional<Options>(options);    
 }
 
-template<typename REAL>
-static void print_row(char const *name, REAL duration, REAL runtime) {
+static void print_name(char const *name) {
     std::cout << std::setprecision(3) << std::fixed;
     std::cout << std::setiosflags (std::ios::left);
     std::cout << std::setw(0) << "| " << std::setw(24) << name;
     std::cout << std::resetiosflags (std::ios::left);
-    std::cout << std::setw(0) << " | " << std::setw(12) << duration;
-    std::cout << std::setw(0) << " | " << std::setw(12) << runtime;
+}
+
+template<typename VALUE>
+static void print_cell(VALUE value) {
+    std::cout << std::setw(0) << " | " << std::setw(12) << value;
+}
+
+static void print_row_end() {
     std::cout << std::setw(0) << " |" << std::endl;
 }
 
-static void print_divider() {
-    std::cout << std::setfill('-') << std::setw(58) << "-" << std::endl;
+template<typename REAL>
+static void print_row(char const *name, REAL duration, REAL runtime) {
+    print_name(name);
+    print_cell(duration);
+    print_cell(runtime);
+    print_row_end();
+}
+
+static void print_divider(uint extra_columns = 0) {
+    std::cout << std::setfill('-') << std::setw(58 + extra_columns * 15) << "-" << std::endl;
     std::cout << std::setfill(' ');
 }
 
-static void print_results(std::vector<Runner::Results> const & results) {
+static void print_results(std::vector<Runner::Results> const & results, Runner::Config const &config) {
+    bool measured = config.real_threads;
+    uint extra_columns = measured ? 7 : 6;
+    auto print_header = [&](char const *name, char const *duration, char const *runtime, char const *latency, char const *efficiency, char const *dispatches, char const *cycles, char const *mean_width, char const *max_width, char const *measured_runtime) {
+        print_name(name);
+        print_cell(duration);
+        print_cell(runtime);
+        print_cell(latency);
+        print_cell(efficiency);
+        print_cell(dispatches);
+        print_cell(cycles);
+        print_cell(mean_width);
+        print_cell(max_width);
+        if (measured) {
+            print_cell(measured_runtime);
+        }
+        print_row_end();
+    };
+
+    print_divider(extra_columns);
+    print_header("ALGORITHM NAME", "ALGORITHM",    "ESTIMATED",   "END-TO-END",  "EFFICIENCY", "DISPATCHES", "CYCLES", "CYCLE WIDTH", "CYCLE WIDTH", "MEASURED"   );
+    print_header("",               "DURATION(ms)", "RUNTIME(ms)", "LATENCY(ms)", "(%)",        "",           "",       "(MEAN)",      "(MAX)",       "RUNTIME(ms)");
+    print_divider(extra_columns);
+    for(auto const &r : results) {
+        print_name(r.scheduler);
+        print_cell(r.duration_ms);
+        print_cell(r.runtime_est_ms);
+        print_cell(r.latency_ms);
+        print_cell(r.efficiency_pct);
+        print_cell(r.dispatches);
+        // graphs have no cycles
+        if (r.cycles > 0) {
+            print_cell(r.cycles);
+            print_cell(r.mean_width);
+            print_cell(r.max_width);
+        } else {
+            print_cell("");
+            print_cell("");
+            print_cell("");
+        }
+        if (measured) {
+            print_cell(r.runtime_measured_ms);
+        }
+        print_row_end();
+    }
+    print_divider(extra_columns);
+    for (auto const &r: results) {
+        if (!r.streaming) {
+            std::cout << boost::format {"EFFICIENCY: the workload's lower bound of %0.03fms as a percentage of the estimated runtime\n"} % r.lower_bound_ms;
+            break;
+        }
+    }
+    for (auto const &r: results) {
+        if (r.streaming) {
+            std::cout << boost::format {"  streaming schedulers: the %0.03fms bound after arrivals as a percentage of the end-to-end latency\n"} % r.lower_bound_ms;
+            break;
+        }
+    }
+}
+
+static void print_timing(std::vector<Runner::Results> const & results) {
+    uint const extra_columns = 5;
+    auto print_header = [](char const *name, char const *const *cells) {
+        print_name(name);
+        for (uint i = 0; i < 7; i++) {
+            print_cell(cells[i]);
+        }
+        print_row_end();
+    };
+
+    static char const *const names[] = {"MIN(ms)", "MEDIAN(ms)", "P90(ms)", "P99(ms)", "MEAN(ms)", "STDDEV(ms)", ""};
+    print_divider(extra_columns);
+    print_header("SCHEDULER TIMING", names);
+    print_divider(extra_columns);
+    for (auto const &r : results) {
+        auto const &t = r.timing;
+        print_name(r.scheduler);
+        print_cell(t.min_ms);
+        print_cell(t.median_ms);
+        print_cell(t.p90_ms);
+        print_cell(t.p99_ms);
+        print_cell(t.mean_ms);
+        print_cell(t.stddev_ms);
+        print_cell(t.noisy ? "NOISY" : "");
+        print_row_end();
+    }
+    print_divider(extra_columns);
+    std::cout << boost::format {"NOISY: the standard deviation is more than %d%% of the mean\n"} % std::lrint(Runner::Timing_stats::NOISY_CV * 100.0);
+}
+
+static void print_scaling(char const *name, std::vector<Runner::Scaling_results> const & results) {
     print_divider();
-    print_row("ALGORITHM NAME", "ALGORITHM",    "ESTIMATED"  );
-    print_row("",               "DURATION(ms)", "RUNTIME(ms)");
+    print_row(name, "ALGORITHM", "SPEEDUP");
+    print_row("HOST THREADS", "DURATION(ms)", "");
     print_divider();
     for(auto const &r : results) {
-        print_row(r.scheduler, r.duration_ms, r.runtime_est_ms);
+        print_row(std::to_string(r.thread_count).c_str(), r.duration_ms, results.front().duration_ms / r.duration_ms);
     }
     print_divider();
 }
 
-int main(int argc, char *argv[]) {
-    
-    auto config = parse_options(argc, argv);
-    if (!config) {
-        return -1;
-    }
+static std::vector<Runner::Results> run_schedulers(Runner::Config const &config, Runner::Workload const &workload) {
+    auto graph_by_hash_conflict_parallel = [&config](std::vector<Transaction> const &transactions) {
+        return algorithms::graph_by_hash_conflict_parallel(transactions, config.host_thread_count);
+    };
 
-    util::scope_profile::init("profile.trace");
-    
-    //print_generated(accounts, transactions);
-    auto results = Runner::execute(*config
+    auto graph_hash_reduced = [](std::vector<Transaction> const &transactions) {
+        return algorithms::transitive_reduction(algorithms::graph_by_hash_conflict(transactions));
+    };
+
+    auto csr_hash_reduced = [](std::vector<Transaction> const &transactions) {
+        return algorithms::transitive_reduction(algorithms::csr_graph_by_hash_conflict(transactions));
+    };
+
+    auto graph_hash_fused = [&config](std::vector<Transaction> const &transactions, util::Array_view<double> costs, uint) {
+        return algorithms::fuse_chains(algorithms::graph_by_hash_conflict(transactions), costs, config.fusion_max_cost_ms);
+    };
+
+    // the reduction drops the shortcut links that keep most chains from being linear
+    auto graph_reduced_fused = [&config](std::vector<Transaction> const &transactions, util::Array_view<double> costs, uint) {
+        return algorithms::fuse_chains(algorithms::transitive_reduction(algorithms::graph_by_hash_conflict(transactions)), costs, config.fusion_max_cost_ms);
+    };
+
+    return Runner::execute(config, workload
         ,"single_thread", algorithms::single_thread
         ,"graph_account_degree", algorithms::graph_by_account_degree
+        ,"csr_account_degree", algorithms::csr_graph_by_account_degree
+        ,"graph_degree_bucket", algorithms::graph_by_account_degree_bucket
+        ,"csr_degree_bucket", algorithms::csr_graph_by_account_degree_bucket
         ,"graph_by_hash_conflict",  algorithms::graph_by_hash_conflict
+        ,"csr_hash_conflict",  algorithms::csr_graph_by_hash_conflict
+        ,"graph_hash_conflict_par",  graph_by_hash_conflict_parallel
+        ,"graph_hash_reduced",  graph_hash_reduced
+        ,"csr_hash_reduced",  csr_hash_reduced
+        ,"graph_hash_fused",  graph_hash_fused
+        ,"graph_reduced_fused",  graph_reduced_fused
         ,"delay_conflicts", algorithms::delay_conflicts
+        ,"delay_conflicts_bitset", algorithms::delay_conflicts_bitset
+        ,"color_saturation", algorithms::color_by_saturation
+        ,"color_degree", algorithms::color_by_degree
+        ,"list_schedule_cost", algorithms::list_schedule_by_cost
+        ,"component_partition", algorithms::partition_by_component
+        ,"stream_hash_conflict", Runner::streaming([](uint expected_transactions) {
+            return algorithms::Streaming_hash_conflict(expected_transactions);
+        })
+        ,"stream_delay_conflicts", Runner::streaming([](uint) {
+            return algorithms::Streaming_delay_conflicts();
+        })
     );
+}
 
-    print_results(results);
+static int run_sweep(Options const &options) {
+    auto const point_count = options.sweep.points(options.config).size();
+    std::cout << boost::format {"Sweeping %d points, %d at a time\n"} % point_count % options.sweep_threads << std::flush;
 
-    util::scope_profile::shutdown();
+    auto rows = options.sweep.run(options.config, options.sweep_threads, run_schedulers);
+
+    if (!Sweep::write(rows, options.sweep_output)) {
+        return -1;
+    }
+
+    std::cout << boost::format {"Wrote %d results to %s\n"} % rows.size() % options.sweep_output;
     return 0;
 }
 
+int main(int argc, char *argv[]) {
+    
+    auto options = parse_options(argc, argv);
+    if (!options) {
+        return -1;
+    }
+
+    auto *config = &options->config;
+
+    if (options->profile_format == util::scope_profile::Format::BINARY) {
+        util::scope_profile::init("profile.bin", 4096, util::scope_profile::Format::BINARY);
+    } else {
+        util::scope_profile::init("profile.trace");
+    }
+
+    if (!options->sweep.axes.empty()) {
+        int result = run_sweep(*options);
+        util::scope_profile::shutdown();
+        return result;
+    }
+
+    Runner::Workload workload;
+    if (!Runner::prepare_workload(*config, workload)) {
+        util::scope_profile::shutdown();
+        return -1;
+    }
+
+    // the profile describes a single run, sweep points run in parallel and would each overwrite it
+    config->emit_properties(util::scope_profile::add_metadata);
+
+    //print_generated(accounts, transactions);
+    auto results = run_schedulers(*config, workload);
+
+    print_results(results, *config);
+
+    if (config->repeat > 1) {
+        print_timing(results);
+    }
+
+    if (options->scheduler_scaling) {
+        print_scaling("graph_hash_conflict_par", Runner::measure_scaling(*config, workload, "graph_hash_conflict_par", algorithms::graph_by_hash_conflict_parallel));
+    }
+
+    util::scope_profile::shutdown();
+    return 0;
+}
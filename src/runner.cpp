@@ -1,8 +1,14 @@
+#include <algorithm>
+#include <cmath>
 #include <iostream>
-#include <set>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <random>
 
 #include "runner.hpp"
 #include "model/account.hpp"
+#include "util/parallel.hpp"
 
 using namespace sched_bench;
 static uint calculate_num_accounts(int index, std::vector<double> const &weights, int max_transactions) {
@@ -29,89 +35,513 @@ static double calculate_target_account_coverage(std::vector<double> const &weigh
 }
 
 
+// transactions are generated in fixed size chunks so the workload depends only on the seed, not the thread count
+static const uint GENERATION_CHUNK_SIZE = 1 << 16;
+
+// each chunk of each generation stage draws from its own stream derived from the seed
+enum class Generation_stream : uint32_t {
+    ACCOUNTS,
+    TRANSACTIONS,
+    SHUFFLE,
+    COSTS,
+    READS,
+};
+
+static std::mt19937_64 make_prng(uint64_t seed, Generation_stream stream, uint chunk) {
+    std::seed_seq seq {static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32), static_cast<uint32_t>(stream), chunk};
+    return std::mt19937_64(seq);
+}
+
+static uint chunk_count(uint count) {
+    return (count + GENERATION_CHUNK_SIZE - 1) / GENERATION_CHUNK_SIZE;
+}
+
 std::vector<Transaction> 
-Runner::generate_transactions(Config const &config) {
+Runner::generate_transactions(Config const &config, std::vector<Account::Id> &account_storage) {
     SCOPE_PROFILE_FUNCTION();
-    // randoms
-    std::random_device rdev;
-    std::mt19937 prng(rdev());
+    auto prng = make_prng(config.seed, Generation_stream::ACCOUNTS, 0);
     std::normal_distribution<> pop_dist(config.account_popularity_mean, config.account_popularity_stddev);
     
-    // generate accounts
-    std::vector<Account::Id> account_bag;
-    std::vector<Account> accounts;
+    // generate accounts and the number of times each one appears in the bag of account references
+    std::vector<uint64_t> bag_counts;
     double account_coverage = 0.0;
     double const target_coverage = calculate_target_account_coverage(config.pct_transactions_per_scope_count);
-    double max_popularity = 0.0;
-    int account_id = 0;
     while(account_coverage < target_coverage) {
-        // if (account_id % 25 == 0) {
-        //     std::cout << "Generating Account " << account_id << std::endl;
-        // }
         double popularity = std::max(0.00001, pop_dist(prng));
-        accounts.emplace_back(Account::Id(account_id), popularity);
-        uint32_t add_to_bag = std::lrint(std::ceil(popularity * (double)config.transaction_count));
-        account_bag.insert(account_bag.cend(), add_to_bag, Account::Id(account_id));
-
+        bag_counts.emplace_back(std::lrint(std::ceil(popularity * (double)config.transaction_count)));
         account_coverage += popularity;
-        account_id++;
-        max_popularity = std::max(max_popularity, popularity);
     }
 
-    // std::cout << "Max popularity: " << max_popularity << std::endl;
+    // every chunk gets a share of each account's references proportional to how many references the chunk will take
+    uint const chunks = chunk_count(config.transaction_count);
+    std::vector<uint64_t> demand_prefix(chunks + 1, 0);
+    for (uint c = 0; c < chunks; c++) {
+        uint chunk_end = std::min(config.transaction_count, (c + 1) * GENERATION_CHUNK_SIZE);
+        uint64_t demand = 0;
+        for (uint i = c * GENERATION_CHUNK_SIZE; i < chunk_end; i++) {
+            demand += calculate_num_accounts(i, config.pct_transactions_per_scope_count, config.transaction_count);
+        }
+        demand_prefix[c + 1] = demand_prefix[c] + demand;
+    }
 
-    // shuffle the account bag
-    // std::cout << "Account bag size: " << account_bag.size() << std::endl;
-    std::shuffle(account_bag.begin(), account_bag.end(), prng);
+    // each chunk collects its account lists in its own pool, the pools are joined once every chunk is done
+    struct Chunk_transaction {
+        uint id;
+        uint account_count;
+        uint write_count;
+    };
 
-    // generate transactions
-    std::vector<Transaction> transactions;
-    transactions.reserve(config.transaction_count);
-    for (uint i = 0; i < config.transaction_count; ++i) {
-        // if (i % (config.transaction_count >> 3) == 0) {
-        //     std::cout << "Generating Transaction " << i << std::endl;
-        // }
-
-        uint num_accounts = calculate_num_accounts(i,config.pct_transactions_per_scope_count, config.transaction_count);
-
-        std::set<Account::Id> referenced_accounts;
-        
-        auto iter = account_bag.rbegin();
-        while (referenced_accounts.size() < num_accounts && iter != account_bag.rend()) {
-            // find the next account, not in the current set
-            auto const &id = *iter;
-            if (referenced_accounts.find(id) == referenced_accounts.end()) {
-                referenced_accounts.insert(id);
-                account_bag.erase(std::next(iter).base());
-            }
+    struct Chunk {
+        std::vector<Account::Id> accounts;
+        std::vector<Chunk_transaction> transactions;
+    };
+
+    std::vector<Chunk> chunk_results(chunks);
+    util::parallel_for(chunks, config.host_thread_count, [&](uint c) {
+        SCOPE_PROFILE("Generate Chunk", c);
+        auto chunk_prng = make_prng(config.seed, Generation_stream::TRANSACTIONS, c);
+        auto read_prng = make_prng(config.seed, Generation_stream::READS, c);
+        std::bernoulli_distribution read_dist(config.read_fraction);
+        uint64_t const total_demand = std::max<uint64_t>(1, demand_prefix[chunks]);
 
-            ++iter;
+        std::vector<Account::Id> account_bag;
+        for (uint a = 0; a < bag_counts.size(); a++) {
+            uint64_t share_begin = bag_counts[a] * demand_prefix[c] / total_demand;
+            uint64_t share_end = bag_counts[a] * demand_prefix[c + 1] / total_demand;
+            account_bag.insert(account_bag.cend(), share_end - share_begin, Account::Id(a));
         }
+        std::shuffle(account_bag.begin(), account_bag.end(), chunk_prng);
 
-        if (referenced_accounts.size() > 0) {
-            transactions.emplace_back(Transaction::Id(i), std::vector<Account::Id>(referenced_accounts.begin(), referenced_accounts.end()));
+        uint chunk_begin = c * GENERATION_CHUNK_SIZE;
+        uint chunk_end = std::min(config.transaction_count, chunk_begin + GENERATION_CHUNK_SIZE);
+        auto &chunk = chunk_results[c];
+        chunk.transactions.reserve(chunk_end - chunk_begin);
+
+        std::vector<Account::Id> referenced_accounts;
+        std::vector<Account::Id> skipped;
+        std::vector<Account::Id> read_accounts;
+        for (uint i = chunk_begin; i < chunk_end; ++i) {
+            uint num_accounts = calculate_num_accounts(i, config.pct_transactions_per_scope_count, config.transaction_count);
+
+            // take accounts from the back of the bag, any already referenced by this transaction are put back afterwards
+            // in their original order so the bag is left exactly as if they had never been looked at
+            referenced_accounts.clear();
+            skipped.clear();
+            while (referenced_accounts.size() < num_accounts && !account_bag.empty()) {
+                auto id = account_bag.back();
+                account_bag.pop_back();
+                if (std::find(referenced_accounts.begin(), referenced_accounts.end(), id) == referenced_accounts.end()) {
+                    referenced_accounts.push_back(id);
+                } else {
+                    skipped.push_back(id);
+                }
+            }
+            account_bag.insert(account_bag.end(), skipped.rbegin(), skipped.rend());
+
+            if (referenced_accounts.size() > 0) {
+                // reads come from their own stream so the accounts a transaction references do not depend on the
+                // read fraction, the written accounts are moved to the front.  The flags are drawn once per account in
+                // order, std::stable_partition leaves the order and number of its predicate calls to the library
+                auto reads_begin = referenced_accounts.end();
+                if (config.read_fraction > 0.0) {
+                    read_accounts.clear();
+                    auto writes_end = referenced_accounts.begin();
+                    for (auto const &id: referenced_accounts) {
+                        if (read_dist(read_prng)) {
+                            read_accounts.push_back(id);
+                        } else {
+                            *writes_end++ = id;
+                        }
+                    }
+                    std::copy(read_accounts.begin(), read_accounts.end(), writes_end);
+                    reads_begin = writes_end;
+                }
+                std::sort(referenced_accounts.begin(), reads_begin);
+                std::sort(reads_begin, referenced_accounts.end());
+                chunk.accounts.insert(chunk.accounts.end(), referenced_accounts.begin(), referenced_accounts.end());
+                chunk.transactions.push_back(Chunk_transaction {i, static_cast<uint>(referenced_accounts.size()), static_cast<uint>(reads_begin - referenced_accounts.begin())});
+            }
         }
+    });
 
+    std::size_t total_accounts = 0;
+    std::size_t total_transactions = 0;
+    for (auto const &chunk: chunk_results) {
+        total_accounts += chunk.accounts.size();
+        total_transactions += chunk.transactions.size();
     }
 
-    std::shuffle(transactions.begin(), transactions.end(), prng);
+    // the pool must not reallocate once transactions point into it
+    account_storage.clear();
+    account_storage.reserve(total_accounts);
+    std::vector<Transaction> transactions;
+    transactions.reserve(total_transactions);
+    for (auto const &chunk: chunk_results) {
+        std::size_t offset = account_storage.size();
+        account_storage.insert(account_storage.end(), chunk.accounts.begin(), chunk.accounts.end());
+        for (auto const &t: chunk.transactions) {
+            transactions.emplace_back(Transaction::Id(t.id), util::Array_view<Account::Id>(account_storage.data() + offset, t.account_count), t.write_count);
+            offset += t.account_count;
+        }
+    }
+
+    auto shuffle_prng = make_prng(config.seed, Generation_stream::SHUFFLE, 0);
+    std::shuffle(transactions.begin(), transactions.end(), shuffle_prng);
     return transactions;
 }
 
-std::map<Transaction::Id, double> 
+std::vector<double> 
 Runner::generate_costs(std::vector<Transaction> const &transactions, Config const &config) {
     SCOPE_PROFILE_FUNCTION();
-    // randoms
-    std::random_device rdev;
-    std::mt19937 prng(rdev());
-    std::normal_distribution<> cost_dist(config.transaction_cost_ms_mean, config.transaction_cost_ms_stddev);
-
-    std::map<Transaction::Id, double> costs;
+    uint max_id = 0;
     for (auto const &t: transactions) {
-        costs.emplace(t.id, std::max(0.001, cost_dist(prng)));
+        max_id = std::max(max_id, t.id.as_numeric());
     }
 
+    // indexed by transaction id, ids are unique so chunks never write the same entry
+    std::vector<double> costs(transactions.empty() ? 0 : max_id + 1, 0.0);
+    uint const chunks = chunk_count(transactions.size());
+    util::parallel_for(chunks, config.host_thread_count, [&](uint c) {
+        auto prng = make_prng(config.seed, Generation_stream::COSTS, c);
+        std::normal_distribution<> cost_dist(config.transaction_cost_ms_mean, config.transaction_cost_ms_stddev);
+        uint chunk_end = std::min<uint>(transactions.size(), (c + 1) * GENERATION_CHUNK_SIZE);
+        for (uint i = c * GENERATION_CHUNK_SIZE; i < chunk_end; i++) {
+            costs[transactions[i].id.as_numeric()] = std::max(0.001, cost_dist(prng));
+        }
+    });
+
     return costs;
 }
 
+void Runner::index_workload(Workload &workload) {
+    SCOPE_PROFILE("Index Transactions By ID");
+    workload.by_id.assign(workload.costs.size(), nullptr);
+    workload.account_count = 0;
+    for (auto const &t: workload.transactions) {
+        workload.by_id[t.id.as_numeric()] = &t;
+        for (auto const &a_id: t.accounts) {
+            workload.account_count = std::max(workload.account_count, a_id.as_numeric() + 1);
+        }
+    }
+}
+
+Runner::Workload
+Runner::generate_workload(Config const &config) {
+    Workload workload;
+    workload.seed = config.seed;
+    workload.transactions = generate_transactions(config, workload.account_storage);
+    workload.cost_storage = generate_costs(workload.transactions, config);
+    workload.costs = workload.cost_storage;
+    index_workload(workload);
+    return workload;
+}
+
+/**
+ * Workload snapshot layout, every section starts on an 8 byte boundary:
+ *
+ *   Workload_file_header
+ *   Workload_file_transaction[transaction_count]   in workload order
+ *   u32 account_ids[account_ref_count]              each transaction's accounts are a slice of this array, the first
+ *                                                   write_count of them are written
+ *   f64 costs[cost_count]                           indexed by transaction id
+ */
+static char const WORKLOAD_MAGIC[8] = {'S', 'B', 'W', 'O', 'R', 'K', '0', '1'};
+static const uint32_t WORKLOAD_VERSION = 2;
+
+struct Workload_file_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t account_count;
+    uint64_t seed;
+    uint64_t transaction_count;
+    uint64_t account_ref_count;
+    uint64_t cost_count;
+};
+
+struct Workload_file_transaction {
+    uint32_t id;
+    uint32_t account_count;
+    uint32_t write_count;
+    uint32_t reserved;
+    uint64_t account_offset;
+};
+
+// version 1 files have no read scopes, every account is written
+struct Workload_file_transaction_v1 {
+    uint32_t id;
+    uint32_t account_count;
+    uint64_t account_offset;
+};
+
+static_assert(sizeof(Account::Id) == sizeof(uint32_t), "account ids are mapped in place as u32");
+static_assert(sizeof(Workload_file_header) % 8 == 0, "unexpected size of struct Workload_file_header");
+static_assert(sizeof(Workload_file_transaction) == 24, "unexpected size of struct Workload_file_transaction");
+static_assert(sizeof(Workload_file_transaction_v1) == 16, "unexpected size of struct Workload_file_transaction_v1");
+
+static std::size_t align_8(std::size_t size) {
+    return (size + 7) & ~std::size_t(7);
+}
+
+bool Runner::save_workload(Workload const &workload, std::string const &filename) {
+    SCOPE_PROFILE("Save Workload");
+    Workload_file_header header;
+    std::memcpy(header.magic, WORKLOAD_MAGIC, sizeof(header.magic));
+    header.version = WORKLOAD_VERSION;
+    header.account_count = workload.account_count;
+    header.seed = workload.seed;
+    header.transaction_count = workload.transactions.size();
+    header.account_ref_count = 0;
+    header.cost_count = workload.costs.size();
+
+    std::vector<Workload_file_transaction> records;
+    records.reserve(workload.transactions.size());
+    for (auto const &t: workload.transactions) {
+        records.push_back(Workload_file_transaction {t.id.as_numeric(), static_cast<uint32_t>(t.accounts.size()), t.write_count, 0, header.account_ref_count});
+        header.account_ref_count += t.accounts.size();
+    }
+
+    std::ofstream out(filename, std::ios::binary);
+    if (!out) {
+        std::cerr << "Unable to open workload file " << filename << " for writing\n";
+        return false;
+    }
+
+    out.write(reinterpret_cast<char const *>(&header), sizeof(header));
+    out.write(reinterpret_cast<char const *>(records.data()), records.size() * sizeof(Workload_file_transaction));
+    for (auto const &t: workload.transactions) {
+        out.write(reinterpret_cast<char const *>(t.accounts.data()), t.accounts.size() * sizeof(Account::Id));
+    }
+
+    static char const padding[8] = {0};
+    std::size_t accounts_size = header.account_ref_count * sizeof(uint32_t);
+    out.write(padding, align_8(accounts_size) - accounts_size);
+    out.write(reinterpret_cast<char const *>(workload.costs.data()), workload.costs.size() * sizeof(double));
+
+    if (!out) {
+        std::cerr << "Failed writing workload file " << filename << "\n";
+        return false;
+    }
+
+    return true;
+}
+
+bool Runner::load_workload(std::string const &filename, Workload &workload) {
+    SCOPE_PROFILE("Load Workload");
+    auto mapping = util::Mapped_file::open(filename);
+    if (!mapping) {
+        std::cerr << "Unable to open workload file " << filename << "\n";
+        return false;
+    }
+
+    auto invalid = [&filename](char const *reason) {
+        std::cerr << "Invalid workload file " << filename << ": " << reason << "\n";
+        return false;
+    };
+
+    if (mapping->size() < sizeof(Workload_file_header)) {
+        return invalid("truncated header");
+    }
+
+    auto const *header = reinterpret_cast<Workload_file_header const *>(mapping->data());
+    if (std::memcmp(header->magic, WORKLOAD_MAGIC, sizeof(WORKLOAD_MAGIC)) != 0) {
+        return invalid("not a workload snapshot");
+    }
+
+    if (header->version != WORKLOAD_VERSION && header->version != 1) {
+        return invalid("unsupported version");
+    }
+
+    // the counts come from the file, each is checked against what is left of the mapping before it is multiplied so a
+    // corrupt header cannot wrap an offset back into range
+    std::size_t const size = mapping->size();
+    std::size_t const record_size = header->version == 1 ? sizeof(Workload_file_transaction_v1) : sizeof(Workload_file_transaction);
+    std::size_t const records_offset = sizeof(Workload_file_header);
+    if (header->transaction_count > (size - records_offset) / record_size) {
+        return invalid("size does not match the header");
+    }
+
+    std::size_t const accounts_offset = records_offset + header->transaction_count * record_size;
+    if (header->account_ref_count > (size - accounts_offset) / sizeof(uint32_t)) {
+        return invalid("size does not match the header");
+    }
+
+    std::size_t const costs_offset = accounts_offset + align_8(header->account_ref_count * sizeof(uint32_t));
+    if (costs_offset > size || header->cost_count > (size - costs_offset) / sizeof(double) || size != costs_offset + header->cost_count * sizeof(double)) {
+        return invalid("size does not match the header");
+    }
+
+    auto const *accounts = reinterpret_cast<Account::Id const *>(mapping->data() + accounts_offset);
+    auto const *costs = reinterpret_cast<double const *>(mapping->data() + costs_offset);
+
+    workload.transactions.clear();
+    workload.transactions.reserve(header->transaction_count);
+    for (uint64_t i = 0; i < header->transaction_count; i++) {
+        Workload_file_transaction r;
+        if (header->version == 1) {
+            auto const &v1 = reinterpret_cast<Workload_file_transaction_v1 const *>(mapping->data() + records_offset)[i];
+            r = Workload_file_transaction {v1.id, v1.account_count, v1.account_count, 0, v1.account_offset};
+        } else {
+            r = reinterpret_cast<Workload_file_transaction const *>(mapping->data() + records_offset)[i];
+        }
+
+        if (r.id >= header->cost_count || r.account_offset > header->account_ref_count || r.account_count > header->account_ref_count - r.account_offset || r.write_count > r.account_count) {
+            return invalid("transaction out of range");
+        }
+        workload.transactions.emplace_back(Transaction::Id(r.id), util::Array_view<Account::Id>(accounts + r.account_offset, r.account_count), r.write_count);
+    }
+
+    for (uint64_t i = 0; i < header->account_ref_count; i++) {
+        if (accounts[i].as_numeric() >= header->account_count) {
+            return invalid("account out of range");
+        }
+    }
+
+    workload.seed = header->seed;
+    workload.costs = util::Array_view<double>(costs, header->cost_count);
+    workload.account_storage.clear();
+    workload.cost_storage.clear();
+    workload.mapping = std::move(mapping);
+    index_workload(workload);
+    return true;
+}
+
+Runner::Timing_stats Runner::Timing_stats::summarize(std::vector<double> samples) {
+    Timing_stats stats {static_cast<uint>(samples.size()), 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, false};
+    if (samples.empty()) {
+        return stats;
+    }
+
+    std::sort(samples.begin(), samples.end());
+    std::size_t const n = samples.size();
+
+    // nearest-rank percentiles
+    auto percentile = [&samples, n](double p) {
+        std::size_t rank = std::ceil(p * n);
+        return samples[std::min(n, std::max<std::size_t>(1, rank)) - 1];
+    };
+
+    stats.min_ms = samples.front();
+    stats.median_ms = (n % 2 == 1) ? samples[n / 2] : (samples[n / 2 - 1] + samples[n / 2]) / 2.0;
+    stats.p90_ms = percentile(0.90);
+    stats.p99_ms = percentile(0.99);
+
+    double sum = 0.0;
+    for (auto s: samples) {
+        sum += s;
+    }
+    stats.mean_ms = sum / n;
+
+    if (n > 1) {
+        double squares = 0.0;
+        for (auto s: samples) {
+            squares += (s - stats.mean_ms) * (s - stats.mean_ms);
+        }
+        stats.stddev_ms = std::sqrt(squares / (n - 1));
+        stats.noisy = stats.mean_ms > 0.0 && stats.stddev_ms / stats.mean_ms > NOISY_CV;
+    }
+
+    return stats;
+}
+
+bool Runner::prepare_workload(Config &config, Workload &workload) {
+    if (!config.load_workload_path.empty() || !config.import_trace_path.empty()) {
+        bool loaded = !config.load_workload_path.empty()
+            ? load_workload(config.load_workload_path, workload)
+            : import_workload(config.import_trace_path, config, workload);
+        if (!loaded) {
+            return false;
+        }
+
+        // the reports take the block's size and seed from the config, which only describes generated workloads
+        config.transaction_count = workload.transactions.size();
+        config.seed = workload.seed;
+    } else {
+        workload = generate_workload(config);
+    }
+
+    if (!config.save_workload_path.empty()) {
+        return save_workload(workload, config.save_workload_path);
+    }
+
+    return true;
+}
+
+// the bounds when the transaction at each index of the workload can start no earlier than arrival(index)
+template<typename ARRIVAL>
+static Runner::Lower_bounds bounds_after_arrivals(Runner::Workload const &workload, uint thread_count, ARRIVAL arrival) {
+    // the earliest a reader and a writer of each account may start, a writer waits for every earlier access
+    std::vector<double> read_ready(workload.account_count, 0.0);
+    std::vector<double> write_ready(workload.account_count, 0.0);
+
+    double total_ms = 0.0;
+    for (auto const &t: workload.transactions) {
+        total_ms += workload.costs[t.id.as_numeric()];
+    }
+
+    // the work still to arrive can not be spread over the threads before it is there
+    double const threads = std::max(1u, thread_count);
+    double critical_path_ms = 0.0;
+    double work_ms = 0.0;
+    double arrived_ms = 0.0;
+    for (std::size_t i = 0; i < workload.transactions.size(); i++) {
+        auto const &t = workload.transactions[i];
+        double start = arrival(i);
+        work_ms = std::max(work_ms, start + (total_ms - arrived_ms) / threads);
+        for (uint a = 0; a < t.accounts.size(); a++) {
+            auto index = t.accounts[a].as_numeric();
+            start = std::max(start, t.writes_account(a) ? write_ready[index] : read_ready[index]);
+        }
+
+        double cost = workload.costs[t.id.as_numeric()];
+        double finish = start + cost;
+        for (uint a = 0; a < t.accounts.size(); a++) {
+            auto index = t.accounts[a].as_numeric();
+            if (t.writes_account(a)) {
+                read_ready[index] = finish;
+                write_ready[index] = finish;
+            } else {
+                write_ready[index] = std::max(write_ready[index], finish);
+            }
+        }
 
+        critical_path_ms = std::max(critical_path_ms, finish);
+        arrived_ms += cost;
+    }
+
+    return Runner::Lower_bounds {critical_path_ms, work_ms};
+}
+
+Runner::Lower_bounds Runner::lower_bounds(Workload const &workload, uint thread_count) {
+    SCOPE_PROFILE("Lower Bounds");
+    return bounds_after_arrivals(workload, thread_count, [](std::size_t) {
+        return 0.0;
+    });
+}
+
+Runner::Lower_bounds Runner::arrival_lower_bounds(Workload const &workload, Config const &config) {
+    SCOPE_PROFILE("Arrival Lower Bounds");
+    return bounds_after_arrivals(workload, config.thread_count, [&config](std::size_t index) {
+        return arrival_ms(config, index);
+    });
+}
+
+void Runner::measure_cycles(Standard_Block const &block, Results &results) {
+    // the entries are sorted by cycle and thread, every change of either starts a span
+    uint spans = 0;
+    uint width = 0;
+    for (uint i = 0; i < block.transactions.size(); i++) {
+        auto const &e = block.transactions[i];
+        bool new_cycle = i == 0 || e.cycle != block.transactions[i - 1].cycle;
+        if (new_cycle) {
+            results.cycles++;
+            width = 0;
+        }
+
+        if (new_cycle || e.thread != block.transactions[i - 1].thread) {
+            spans++;
+            results.max_width = std::max(results.max_width, ++width);
+        }
+    }
+
+    results.mean_width = results.cycles > 0 ? double(spans) / results.cycles : 0.0;
+}
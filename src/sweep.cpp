@@ -0,0 +1,350 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <boost/algorithm/string.hpp>
+#include <boost/format.hpp>
+
+#include "sweep.hpp"
+#include "util/output.hpp"
+#include "util/parallel.hpp"
+
+using namespace sched_bench;
+
+namespace {
+
+bool parse_double(std::string const &text, double &value) {
+    char *end = nullptr;
+    value = std::strtod(text.c_str(), &end);
+    return !text.empty() && *end == '\0';
+}
+
+bool parse_uint(std::string const &text, uint64_t &value) {
+    char *end = nullptr;
+    value = std::strtoull(text.c_str(), &end, 10);
+    return !text.empty() && text[0] != '-' && *end == '\0';
+}
+
+bool parse_distribution(std::string const &text, std::vector<double> &value) {
+    std::vector<std::string> parts;
+    boost::split(parts, text, boost::is_any_of(","));
+    value.clear();
+    for (auto const &p: parts) {
+        double d;
+        if (!parse_double(boost::trim_copy(p), d)) {
+            return false;
+        }
+        value.push_back(d);
+    }
+    return !value.empty();
+}
+
+struct Field {
+    char const *name;
+    bool (*apply)(Runner::Config &config, std::string const &value);
+};
+
+template<typename T>
+bool apply_uint(T &field, std::string const &value) {
+    uint64_t parsed;
+    if (!parse_uint(value, parsed)) {
+        return false;
+    }
+    field = static_cast<T>(parsed);
+    return true;
+}
+
+bool apply_double(double &field, std::string const &value) {
+    return parse_double(value, field);
+}
+
+// the names match the command line options they override
+Field const FIELDS[] = {
+    {"transactions", [](Runner::Config &c, std::string const &v) { return apply_uint(c.transaction_count, v); }},
+    {"repeat", [](Runner::Config &c, std::string const &v) { return apply_uint(c.repeat, v) && c.repeat > 0; }},
+    {"warmup", [](Runner::Config &c, std::string const &v) { return apply_uint(c.warmup, v); }},
+    {"threads", [](Runner::Config &c, std::string const &v) { return apply_uint(c.thread_count, v) && c.thread_count > 0; }},
+    {"seed", [](Runner::Config &c, std::string const &v) { return apply_uint(c.seed, v); }},
+    {"avg-cost", [](Runner::Config &c, std::string const &v) { return apply_double(c.transaction_cost_ms_mean, v); }},
+    {"stddev-cost", [](Runner::Config &c, std::string const &v) { return apply_double(c.transaction_cost_ms_stddev, v); }},
+    {"avg-popularity", [](Runner::Config &c, std::string const &v) { return apply_double(c.account_popularity_mean, v); }},
+    {"stddev-popularity", [](Runner::Config &c, std::string const &v) { return apply_double(c.account_popularity_stddev, v); }},
+    {"read-fraction", [](Runner::Config &c, std::string const &v) { return apply_double(c.read_fraction, v) && c.read_fraction >= 0.0 && c.read_fraction <= 1.0; }},
+    {"arrival-interval", [](Runner::Config &c, std::string const &v) { return apply_double(c.arrival_interval_ms, v) && c.arrival_interval_ms >= 0.0; }},
+    {"arrival-batch", [](Runner::Config &c, std::string const &v) { return apply_uint(c.arrival_batch, v) && c.arrival_batch > 0; }},
+    {"dispatch-latency", [](Runner::Config &c, std::string const &v) { return apply_double(c.dispatch_latency_ms, v) && c.dispatch_latency_ms >= 0.0; }},
+    {"next-cost", [](Runner::Config &c, std::string const &v) { return apply_double(c.next_cost_ms, v) && c.next_cost_ms >= 0.0; }},
+    {"finalize-cost", [](Runner::Config &c, std::string const &v) { return apply_double(c.finalize_cost_ms, v) && c.finalize_cost_ms >= 0.0; }},
+    {"barrier-cost", [](Runner::Config &c, std::string const &v) { return apply_double(c.barrier_cost_ms, v) && c.barrier_cost_ms >= 0.0; }},
+    {"scope-distribution", [](Runner::Config &c, std::string const &v) { return parse_distribution(v, c.pct_transactions_per_scope_count); }},
+};
+
+Field const *find_field(std::string const &name) {
+    for (auto const &f: FIELDS) {
+        if (name == f.name) {
+            return &f;
+        }
+    }
+    return nullptr;
+}
+
+std::string format_value(double value) {
+    return (boost::format {"%.10g"} % value).str();
+}
+
+// expand "start:stop[:step]" or "start:stop:*factor"
+bool expand_range(std::string const &range, std::vector<std::string> &values) {
+    std::vector<std::string> parts;
+    boost::split(parts, range, boost::is_any_of(":"));
+    double start, stop, step = 1.0;
+    if (parts.size() < 2 || parts.size() > 3 || !parse_double(parts[0], start) || !parse_double(parts[1], stop) || stop < start) {
+        return false;
+    }
+
+    bool geometric = parts.size() == 3 && !parts[2].empty() && parts[2][0] == '*';
+    if (parts.size() == 3 && !parse_double(geometric ? parts[2].substr(1) : parts[2], step)) {
+        return false;
+    }
+
+    static const uint MAX_VALUES = 100000;
+    if (geometric) {
+        if (step <= 1.0 || start <= 0.0) {
+            return false;
+        }
+        for (double v = start; v <= stop * (1.0 + 1e-9) && values.size() < MAX_VALUES; v *= step) {
+            values.push_back(format_value(v));
+        }
+    } else {
+        if (step <= 0.0) {
+            return false;
+        }
+        uint64_t count = std::floor((stop - start) / step + 1e-9) + 1;
+        for (uint64_t i = 0; i < count && values.size() < MAX_VALUES; i++) {
+            values.push_back(format_value(start + i * step));
+        }
+    }
+
+    return true;
+}
+
+std::string csv_escape(std::string const &value) {
+    if (value.find_first_of(",\"\n") == std::string::npos) {
+        return value;
+    }
+    return "\"" + boost::replace_all_copy(value, "\"", "\"\"") + "\"";
+}
+
+std::string json_string(std::string const &value) {
+    std::string result = "\"";
+    for (auto c: value) {
+        if (c == '"' || c == '\\') {
+            result.push_back('\\');
+        }
+        result.push_back(c);
+    }
+    return result + "\"";
+}
+
+// booleans, finite numbers and the bracketed distributions from emit_properties are already valid JSON, JSON has no
+// NaN or infinity so those are written as null
+std::string json_value(std::string const &value) {
+    double number;
+    if (parse_double(value, number)) {
+        return std::isfinite(number) ? value : "null";
+    }
+    if (value == "true" || value == "false" || (!value.empty() && value[0] == '[')) {
+        return value;
+    }
+    return json_string(value);
+}
+
+std::vector<std::pair<std::string, std::string>> result_columns(Runner::Results const &r) {
+    return {
+        {"schedulerTimeMs", format_value(r.duration_ms)},
+        {"estimatedRuntimeMs", format_value(r.runtime_est_ms)},
+        {"latencyMs", format_value(r.latency_ms)},
+        {"measuredRuntimeMs", format_value(r.runtime_measured_ms)},
+        {"lowerBoundMs", format_value(r.lower_bound_ms)},
+        {"efficiencyPct", format_value(r.efficiency_pct)},
+        {"cycles", std::to_string(r.cycles)},
+        {"meanCycleWidth", format_value(r.mean_width)},
+        {"maxCycleWidth", std::to_string(r.max_width)},
+        {"schedulerTimeMinMs", format_value(r.timing.min_ms)},
+        {"schedulerTimeP90Ms", format_value(r.timing.p90_ms)},
+        {"schedulerTimeP99Ms", format_value(r.timing.p99_ms)},
+        {"schedulerTimeMeanMs", format_value(r.timing.mean_ms)},
+        {"schedulerTimeStddevMs", format_value(r.timing.stddev_ms)},
+        {"schedulerTimeNoisy", r.timing.noisy ? "true" : "false"},
+        {"retiredTransactions", std::to_string(r.transactions_retired)},
+        {"dispatches", std::to_string(r.dispatches)},
+        {"valid", r.valid ? "true" : "false"},
+        {"errorMessage", r.error_message},
+    };
+}
+
+}
+
+bool Sweep::add_axis(std::string const &spec) {
+    auto equals = spec.find('=');
+    Axis axis;
+    axis.field = boost::trim_copy(spec.substr(0, equals));
+    auto const *field = find_field(axis.field);
+    if (equals == std::string::npos || field == nullptr) {
+        auto const names = fields();
+        std::cerr << "Error: unknown sweep field in \"" << spec << "\", expected one of " << boost::algorithm::join(std::vector<std::string>(names.begin(), names.end()), ", ") << "\n";
+        return false;
+    }
+
+    std::string values = spec.substr(equals + 1);
+    std::vector<std::string> items;
+    boost::split(items, values, boost::is_any_of(axis.field == "scope-distribution" ? ";" : ","));
+    for (auto &item: items) {
+        boost::trim(item);
+        if (axis.field != "scope-distribution" && item.find(':') != std::string::npos) {
+            if (!expand_range(item, axis.values)) {
+                std::cerr << "Error: invalid sweep range \"" << item << "\" for " << axis.field << "\n";
+                return false;
+            }
+        } else {
+            axis.values.push_back(item);
+        }
+    }
+
+    Runner::Config check = Runner::Config();
+    for (auto const &v: axis.values) {
+        if (!field->apply(check, v)) {
+            std::cerr << "Error: invalid sweep value \"" << v << "\" for " << axis.field << "\n";
+            return false;
+        }
+    }
+
+    if (axis.values.empty()) {
+        std::cerr << "Error: no values to sweep for " << axis.field << "\n";
+        return false;
+    }
+
+    axes.push_back(std::move(axis));
+    return true;
+}
+
+std::vector<Runner::Config> Sweep::points(Runner::Config const &base) const {
+    std::vector<Runner::Config> result {base};
+    for (auto const &axis: axes) {
+        auto const *field = find_field(axis.field);
+        std::vector<Runner::Config> expanded;
+        expanded.reserve(result.size() * axis.values.size());
+        for (auto const &config: result) {
+            for (auto const &v: axis.values) {
+                expanded.push_back(config);
+                field->apply(expanded.back(), v);
+            }
+        }
+        result = std::move(expanded);
+    }
+    return result;
+}
+
+std::vector<Sweep::Row> Sweep::run(Runner::Config const &base, uint thread_count, Run_fn const &run_fn) const {
+    auto const configs = points(base);
+    std::vector<std::vector<Row>> point_rows(configs.size());
+
+    // points running side by side share the host, each times its schedulers on its own share of the threads
+    uint const concurrent_points = std::max(1u, std::min<uint>(thread_count, configs.size()));
+    uint const host_threads_per_point = std::max(1u, base.host_thread_count / concurrent_points);
+    std::mutex progress_mutex;
+    uint completed = 0;
+
+    util::parallel_for(configs.size(), thread_count, [&](uint point) {
+        SCOPE_PROFILE("Sweep Point", point);
+        // the reports of points running side by side would interleave, only the progress is shown
+        std::ostream discard(nullptr);
+        util::Redirect_output redirect(discard);
+
+        auto config = configs[point];
+        config.host_thread_count = host_threads_per_point;
+        Runner::Workload workload;
+        bool prepared = Runner::prepare_workload(config, workload);
+        if (prepared) {
+            std::vector<std::pair<std::string, std::string>> properties;
+            config.emit_properties([&properties](char const *k, char const *v) {
+                properties.emplace_back(k, v);
+            });
+
+            for (auto &r: run_fn(config, workload)) {
+                point_rows[point].push_back(Row {point, properties, std::move(r)});
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(progress_mutex);
+        completed++;
+        std::clog << boost::format {"Sweep point %d (%d of %d)%s\n"} % point % completed % configs.size() % (prepared ? "" : " failed");
+    });
+
+    std::vector<Row> rows;
+    for (auto &p: point_rows) {
+        std::move(p.begin(), p.end(), std::back_inserter(rows));
+    }
+    return rows;
+}
+
+std::vector<char const *> Sweep::fields() {
+    std::vector<char const *> result;
+    for (auto const &f: FIELDS) {
+        result.push_back(f.name);
+    }
+    return result;
+}
+
+bool Sweep::write(std::vector<Row> const &rows, std::string const &filename) {
+    std::ofstream out(filename);
+    if (!out) {
+        std::cerr << "Unable to open sweep output " << filename << "\n";
+        return false;
+    }
+
+    bool json = boost::algorithm::ends_with(filename, ".json");
+    if (json) {
+        out << "[\n";
+        for (uint i = 0; i < rows.size(); i++) {
+            auto const &row = rows[i];
+            out << "  {\"point\":" << row.point << ",\"scheduler\":" << json_string(row.results.scheduler);
+            for (auto const &p: row.properties) {
+                out << "," << json_string(p.first) << ":" << json_value(p.second);
+            }
+            for (auto const &c: result_columns(row.results)) {
+                out << "," << json_string(c.first) << ":" << (c.first == "errorMessage" ? json_string(c.second) : json_value(c.second));
+            }
+            out << (i + 1 < rows.size() ? "},\n" : "}\n");
+        }
+        out << "]\n";
+    } else if (!rows.empty()) {
+        // every row shares the same properties, so the header comes from the first one
+        out << "point,scheduler";
+        for (auto const &p: rows.front().properties) {
+            out << "," << p.first;
+        }
+        for (auto const &c: result_columns(rows.front().results)) {
+            out << "," << c.first;
+        }
+        out << "\n";
+
+        for (auto const &row: rows) {
+            out << row.point << "," << csv_escape(row.results.scheduler);
+            for (auto const &p: row.properties) {
+                out << "," << csv_escape(p.second);
+            }
+            for (auto const &c: result_columns(row.results)) {
+                out << "," << csv_escape(c.second);
+            }
+            out << "\n";
+        }
+    }
+
+    if (!out) {
+        std::cerr << "Failed writing sweep output " << filename << "\n";
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,77 @@
+#include <boost/program_options.hpp>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+#include "util/profile_format.hpp"
+
+using namespace sched_bench::util;
+namespace po = boost::program_options;
+
+/**
+ * Converts a compact binary profile written with --profile-format binary into Chrome trace event JSON or a Perfetto
+ * protobuf trace
+ */
+int main(int argc, char *argv[]) {
+    std::string input;
+    std::string output;
+    std::string format;
+
+    po::options_description desc("Options:");
+    desc.add_options()
+        ("help", "show this help message")
+        ("input,i", po::value<std::string>(&input)->default_value("profile.bin"), "The binary profile to convert")
+        ("output,o", po::value<std::string>(&output)->default_value("profile.trace"), "The file to write")
+        ("format,f", po::value<std::string>(&format)->default_value("json"), "The output format: json or perfetto")
+        ;
+
+    po::positional_options_description positional;
+    positional.add("input", 1).add("output", 1);
+
+    po::variables_map vm;
+    try {
+        po::store(po::command_line_parser(argc, argv).options(desc).positional(positional).run(), vm);
+        if (vm.count("help")) {
+            std::cout << desc << "\n";
+            return 0;
+        }
+        po::notify(vm);
+    } catch(std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return -1;
+    }
+
+    if (format != "json" && format != "perfetto") {
+        std::cerr << "Error: unknown output format \"" << format << "\"\n";
+        return -1;
+    }
+
+    std::FILE *file = std::fopen(input.c_str(), "rb");
+    if (file == nullptr) {
+        std::cerr << "Error: cannot open " << input << "\n";
+        return -1;
+    }
+
+    scope_profile::Profile profile;
+    bool read = scope_profile::read_binary(file, profile);
+    std::fclose(file);
+    if (!read) {
+        std::cerr << "Error: " << input << " is not a valid binary profile\n";
+        return -1;
+    }
+
+    std::ofstream out(output, std::ios::binary);
+    if (format == "json") {
+        scope_profile::write_chrome_json(out, profile);
+    } else {
+        scope_profile::write_perfetto(out, profile);
+    }
+
+    if (!out) {
+        std::cerr << "Error: failed writing " << output << "\n";
+        return -1;
+    }
+
+    std::cout << "Converted " << profile.records.size() << " samples to " << output << "\n";
+    return 0;
+}
@@ -0,0 +1,86 @@
+#include <cstdio>
+#include "util/mapped_file.hpp"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace sched_bench { namespace util {
+
+Mapped_file::Mapped_file(char const *data, std::size_t size, bool mapped)
+    : _data(data)
+    , _size(size)
+    , _mapped(mapped)
+{
+}
+
+#ifndef _WIN32
+
+std::unique_ptr<Mapped_file> Mapped_file::open(std::string const &filename) {
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return nullptr;
+    }
+
+    struct stat info;
+    if (::fstat(fd, &info) != 0) {
+        ::close(fd);
+        return nullptr;
+    }
+
+    std::size_t size = info.st_size;
+    if (size == 0) {
+        ::close(fd);
+        return std::unique_ptr<Mapped_file>(new Mapped_file(nullptr, 0, false));
+    }
+
+    void *data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        return nullptr;
+    }
+
+    return std::unique_ptr<Mapped_file>(new Mapped_file(static_cast<char const *>(data), size, true));
+}
+
+Mapped_file::~Mapped_file() {
+    if (_mapped) {
+        ::munmap(const_cast<char *>(_data), _size);
+    } else {
+        delete[] _data;
+    }
+}
+
+#else
+
+std::unique_ptr<Mapped_file> Mapped_file::open(std::string const &filename) {
+    std::FILE *file = std::fopen(filename.c_str(), "rb");
+    if (file == nullptr) {
+        return nullptr;
+    }
+
+    std::fseek(file, 0, SEEK_END);
+    std::size_t size = std::ftell(file);
+    std::rewind(file);
+
+    char *data = new char[size];
+    if (std::fread(data, 1, size, file) != size) {
+        delete[] data;
+        std::fclose(file);
+        return nullptr;
+    }
+
+    std::fclose(file);
+    return std::unique_ptr<Mapped_file>(new Mapped_file(data, size, false));
+}
+
+Mapped_file::~Mapped_file() {
+    delete[] _data;
+}
+
+#endif
+
+}}
@@ -0,0 +1,294 @@
+#include <boost/format.hpp>
+#include <cstring>
+#include <map>
+#include "util/profile_format.hpp"
+
+namespace sched_bench { namespace util { namespace scope_profile {
+
+const uint32_t Profile::VERSION;
+
+static char const PROFILE_MAGIC[8] = {'S', 'B', 'P', 'R', 'O', 'F', '0', '1'};
+
+std::string Profile::record_name(Sample_record const &record) const {
+    std::string result = record.name_id < names.size() ? names[record.name_id] : std::string("?");
+    char buf[64];
+    for (uint i = 0; i < Sample_record::MAX_ARGS; i++) {
+        switch (record.arg_type(i)) {
+            case Sample_arg_type::INT:
+                std::snprintf(buf, sizeof(buf), "%lld", static_cast<long long>(record.args[i]));
+                result += buf;
+                break;
+            case Sample_arg_type::DOUBLE: {
+                double value;
+                std::memcpy(&value, &record.args[i], sizeof(value));
+                std::snprintf(buf, sizeof(buf), "%0.04f", value);
+                result += buf;
+                break;
+            }
+            case Sample_arg_type::STRING:
+                if (static_cast<uint64_t>(record.args[i]) < names.size()) {
+                    result += names[record.args[i]];
+                }
+                break;
+            default:
+                break;
+        }
+    }
+
+    return result;
+}
+
+uint64_t Profile::record_time_us(Sample_record const &record) const {
+    if (record.ticks < epoch_ticks || ticks_per_us <= 0.0) {
+        return 0;
+    }
+
+    return static_cast<uint64_t>((record.ticks - epoch_ticks) / ticks_per_us);
+}
+
+template<typename T>
+static void write_value(std::FILE *file, T const &value) {
+    std::fwrite(&value, sizeof(T), 1, file);
+}
+
+static void write_string(std::FILE *file, std::string const &value) {
+    write_value<uint32_t>(file, value.size());
+    std::fwrite(value.data(), 1, value.size(), file);
+}
+
+template<typename T>
+static bool read_value(std::FILE *file, T &value) {
+    return std::fread(&value, sizeof(T), 1, file) == 1;
+}
+
+static bool read_string(std::FILE *file, std::string &value) {
+    uint32_t length;
+    if (!read_value(file, length)) {
+        return false;
+    }
+
+    value.resize(length);
+    return length == 0 || std::fread(&value[0], 1, length, file) == length;
+}
+
+bool write_binary(std::FILE *file, Profile const &profile) {
+    std::fwrite(PROFILE_MAGIC, 1, sizeof(PROFILE_MAGIC), file);
+    write_value<uint32_t>(file, Profile::VERSION);
+    write_value<double>(file, profile.ticks_per_us);
+    write_value<uint64_t>(file, profile.epoch_ticks);
+    write_value<int64_t>(file, profile.start_time);
+    write_value<int64_t>(file, profile.end_time);
+    write_value<uint64_t>(file, profile.dropped_samples);
+
+    write_value<uint32_t>(file, profile.names.size());
+    for (auto const &n: profile.names) {
+        write_string(file, n);
+    }
+
+    write_value<uint32_t>(file, profile.metadata.size());
+    for (auto const &m: profile.metadata) {
+        write_string(file, m.first);
+        write_string(file, m.second);
+    }
+
+    write_value<uint64_t>(file, profile.records.size());
+    std::fwrite(profile.records.data(), sizeof(Sample_record), profile.records.size(), file);
+    return std::ferror(file) == 0;
+}
+
+bool read_binary(std::FILE *file, Profile &profile) {
+    char magic[sizeof(PROFILE_MAGIC)];
+    uint32_t version;
+    int64_t start_time, end_time;
+    if (std::fread(magic, 1, sizeof(magic), file) != sizeof(magic) || std::memcmp(magic, PROFILE_MAGIC, sizeof(magic)) != 0) {
+        return false;
+    }
+
+    if (!read_value(file, version) || version != Profile::VERSION) {
+        return false;
+    }
+
+    if (!read_value(file, profile.ticks_per_us) || !read_value(file, profile.epoch_ticks) || !read_value(file, start_time) || !read_value(file, end_time) || !read_value(file, profile.dropped_samples)) {
+        return false;
+    }
+    profile.start_time = start_time;
+    profile.end_time = end_time;
+
+    uint32_t count;
+    if (!read_value(file, count)) {
+        return false;
+    }
+    profile.names.resize(count);
+    for (auto &n: profile.names) {
+        if (!read_string(file, n)) {
+            return false;
+        }
+    }
+
+    if (!read_value(file, count)) {
+        return false;
+    }
+    profile.metadata.resize(count);
+    for (auto &m: profile.metadata) {
+        if (!read_string(file, m.first) || !read_string(file, m.second)) {
+            return false;
+        }
+    }
+
+    uint64_t record_count;
+    if (!read_value(file, record_count)) {
+        return false;
+    }
+    profile.records.resize(record_count);
+    return std::fread(profile.records.data(), sizeof(Sample_record), record_count, file) == record_count;
+}
+
+void write_chrome_json(std::ostream &out, Profile const &profile) {
+    out
+        << boost::format {"{ \"traceStartTime\": \"%.24s\" ,\"traceEvents\": [\n" }
+        % std::ctime(&profile.start_time);
+
+    char const *sep = "";
+    for (auto const &record: profile.records) {
+        out
+            << sep
+            << boost::format { "{\"tid\":%s,\"pid\":%s,\"ts\":%d,\"cat\":\"P\"," }
+            % record.tid
+            % record.tid
+            % profile.record_time_us(record)
+            ;
+
+        if (record.type == Sample_record_type::BEGIN) {
+            out << "\"ph\":\"B\",\"name\":\"" << profile.record_name(record) << "\"}";
+        } else if (record.type == Sample_record_type::END) {
+            out << "\"ph\":\"E\"}";
+        }
+
+        sep = ",\n";
+    }
+
+    out
+        << boost::format {"]\n, \"traceEndTime\": \"%.24s\"" } % std::ctime(&profile.end_time)
+        << boost::format {",\n \"droppedSamples\":%d" } % profile.dropped_samples;
+
+    for (auto const &e: profile.metadata) {
+        out << boost::format {",\n \"%s\":\"%s\""} % e.first % e.second;
+    }
+
+    out << "}";
+}
+
+/**
+ * Minimal protobuf encoder for the handful of perfetto.protos.Trace fields we need
+ */
+struct Proto_writer {
+    std::string bytes;
+
+    void varint(uint64_t value) {
+        while (value >= 0x80) {
+            bytes.push_back(static_cast<char>((value & 0x7F) | 0x80));
+            value >>= 7;
+        }
+        bytes.push_back(static_cast<char>(value));
+    }
+
+    void tag(uint field, uint wire_type) {
+        varint((field << 3) | wire_type);
+    }
+
+    void uint_field(uint field, uint64_t value) {
+        tag(field, 0);
+        varint(value);
+    }
+
+    void bytes_field(uint field, std::string const &value) {
+        tag(field, 2);
+        varint(value.size());
+        bytes += value;
+    }
+};
+
+void write_perfetto(std::ostream &out, Profile const &profile) {
+    // Trace.packet
+    static const uint TRACE_PACKET = 1;
+    // TracePacket
+    static const uint PACKET_TIMESTAMP = 8;
+    static const uint PACKET_SEQUENCE_ID = 10;
+    static const uint PACKET_TRACK_EVENT = 11;
+    static const uint PACKET_TRACK_DESCRIPTOR = 60;
+    // TrackDescriptor
+    static const uint TRACK_UUID = 1;
+    static const uint TRACK_PROCESS = 3;
+    static const uint TRACK_THREAD = 4;
+    // ProcessDescriptor / ThreadDescriptor
+    static const uint PROCESS_PID = 1;
+    static const uint PROCESS_NAME = 6;
+    static const uint THREAD_PID = 1;
+    static const uint THREAD_TID = 2;
+    static const uint THREAD_NAME = 5;
+    // TrackEvent
+    static const uint EVENT_TYPE = 9;
+    static const uint EVENT_TRACK_UUID = 11;
+    static const uint EVENT_NAME = 23;
+    static const uint TYPE_SLICE_BEGIN = 1;
+    static const uint TYPE_SLICE_END = 2;
+
+    static const uint PID = 1;
+    static const uint SEQUENCE_ID = 1;
+    static const uint64_t PROCESS_UUID = 1;
+    auto thread_uuid = [](uint tid) -> uint64_t { return 1000 + tid; };
+
+    auto emit_packet = [&out](Proto_writer const &packet) {
+        Proto_writer trace;
+        trace.bytes_field(TRACE_PACKET, packet.bytes);
+        out.write(trace.bytes.data(), trace.bytes.size());
+    };
+
+    {
+        Proto_writer process;
+        process.uint_field(PROCESS_PID, PID);
+        process.bytes_field(PROCESS_NAME, "sched_bench");
+        Proto_writer track;
+        track.uint_field(TRACK_UUID, PROCESS_UUID);
+        track.bytes_field(TRACK_PROCESS, process.bytes);
+        Proto_writer packet;
+        packet.bytes_field(PACKET_TRACK_DESCRIPTOR, track.bytes);
+        emit_packet(packet);
+    }
+
+    std::map<uint, bool> threads;
+    for (auto const &record: profile.records) {
+        if (threads.emplace(record.tid, true).second) {
+            Proto_writer thread;
+            thread.uint_field(THREAD_PID, PID);
+            thread.uint_field(THREAD_TID, record.tid + 1);
+            thread.bytes_field(THREAD_NAME, (boost::format {"thread %d"} % record.tid).str());
+            Proto_writer track;
+            track.uint_field(TRACK_UUID, thread_uuid(record.tid));
+            track.bytes_field(TRACK_THREAD, thread.bytes);
+            Proto_writer packet;
+            packet.bytes_field(PACKET_TRACK_DESCRIPTOR, track.bytes);
+            emit_packet(packet);
+        }
+
+        Proto_writer event;
+        if (record.type == Sample_record_type::BEGIN) {
+            event.uint_field(EVENT_TYPE, TYPE_SLICE_BEGIN);
+            event.uint_field(EVENT_TRACK_UUID, thread_uuid(record.tid));
+            event.bytes_field(EVENT_NAME, profile.record_name(record));
+        } else if (record.type == Sample_record_type::END) {
+            event.uint_field(EVENT_TYPE, TYPE_SLICE_END);
+            event.uint_field(EVENT_TRACK_UUID, thread_uuid(record.tid));
+        } else {
+            continue;
+        }
+
+        Proto_writer packet;
+        packet.uint_field(PACKET_TIMESTAMP, profile.record_time_us(record) * 1000);
+        packet.uint_field(PACKET_SEQUENCE_ID, SEQUENCE_ID);
+        packet.bytes_field(PACKET_TRACK_EVENT, event.bytes);
+        emit_packet(packet);
+    }
+}
+
+}}}
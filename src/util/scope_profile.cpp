@@ -1,11 +1,18 @@
+#include <algorithm>
 #include <atomic>
-#include <boost/format.hpp>
 #include <boost/optional.hpp>
 #include <cstdio>
+#include <cstring>
 #include <ctime>
+#include <deque>
 #include <fstream>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
 #include "util/scope_profile.hpp"
 
 namespace sched_bench { namespace util { namespace scope_profile {
@@ -14,103 +21,322 @@ static std::map<std::string, std::string> metadata;
 
 static std::thread *output_thread;
 static std::atomic_bool done(false);
-
-static std::atomic_uint write_record_offset(0);
-static Sample_record *Sample_records = nullptr;
 static uint Max_sample_records = 0;
 
-void output_thread_entry(char const *filename, std::chrono::steady_clock::time_point epoch) {
-    std::chrono::milliseconds sleep_time {15};
+/**
+ * Single-producer/single-consumer ring owned by one instrumented thread.  The owner writes a record and then publishes
+ * it by advancing head with release semantics, the output thread reads up to head with acquire semantics and hands the
+ * slots back by advancing tail.  When the owner exits it marks the ring retired, once the output thread has drained a
+ * retired ring it is put on the free list for the next new thread.
+ */
+struct Thread_ring {
+    Thread_ring(uint _tid, uint _capacity)
+        : tid(_tid)
+        , capacity(_capacity)
+        , records(new Sample_record[_capacity])
+        , head(0)
+        , cached_tail(0)
+        , open_depth(0)
+        , suppressed_depth(0)
+        , retired(false)
+        , tail(0)
+        , dropped(0)
+    {
+    }
+
+    // a drained ring taken from the free list by a new owner, head and tail are equal and carry on from where they are
+    void reuse(uint _tid) {
+        tid = _tid;
+        cached_tail = tail.load(std::memory_order_relaxed);
+        open_depth = 0;
+        suppressed_depth = 0;
+        retired.store(false, std::memory_order_relaxed);
+    }
+
+    uint tid;
+    uint const capacity;
+    std::unique_ptr<Sample_record[]> records;
+
+    // producer side
+    std::atomic<uint64_t> head;
+    uint64_t cached_tail;
+    uint open_depth;
+    uint suppressed_depth;
+    std::atomic_bool retired;
+    char producer_padding[64];
+
+    // consumer side
+    std::atomic<uint64_t> tail;
+    std::atomic<uint64_t> dropped;
+};
+
+static std::mutex rings_mutex;
+static std::vector<std::unique_ptr<Thread_ring>> rings;
+static std::vector<std::unique_ptr<Thread_ring>> free_rings;
+thread_local Thread_ring *this_thread_ring = nullptr;
+
+// retires the thread's ring when the thread exits, everything it published before is seen with the flag
+struct Ring_owner {
+    ~Ring_owner() {
+        if (this_thread_ring != nullptr) {
+            this_thread_ring->retired.store(true, std::memory_order_release);
+        }
+    }
+};
+
+thread_local Ring_owner this_thread_ring_owner;
+
+static Thread_ring &get_thread_ring() {
+    if (this_thread_ring == nullptr) {
+        std::lock_guard<std::mutex> lock(rings_mutex);
+        if (free_rings.empty()) {
+            rings.emplace_back(new Thread_ring(get_thread_id(), Max_sample_records));
+        } else {
+            rings.emplace_back(std::move(free_rings.back()));
+            free_rings.pop_back();
+            rings.back()->reuse(get_thread_id());
+        }
+        this_thread_ring = rings.back().get();
+        (void)this_thread_ring_owner;
+    }
+
+    return *this_thread_ring;
+}
+
+// move the drained rings of exited threads to the free list, only the output thread removes rings
+static void recycle_rings(std::vector<Thread_ring *> const &drained) {
+    if (drained.empty()) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(rings_mutex);
+    for (auto *ring: drained) {
+        auto iter = std::find_if(rings.begin(), rings.end(), [ring](std::unique_ptr<Thread_ring> const &r) {
+            return r.get() == ring;
+        });
+        free_rings.emplace_back(std::move(*iter));
+        rings.erase(iter);
+    }
+}
+
+// copy any published records from every ring to the temp file, returns the number of records written
+static uint drain_rings(std::FILE *temp_file) {
+    // rings live until shutdown and only this thread recycles them, so it is safe to drain a snapshot without the lock
+    std::vector<Thread_ring *> snapshot;
+    {
+        std::lock_guard<std::mutex> lock(rings_mutex);
+        for (auto const &ring: rings) {
+            snapshot.push_back(ring.get());
+        }
+    }
+
+    uint drained = 0;
+    std::vector<Thread_ring *> retired;
+    for (auto *ring: snapshot) {
+        // a ring retired before head is read has published everything it ever will
+        bool owner_exited = ring->retired.load(std::memory_order_acquire);
+        uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+        uint64_t head = ring->head.load(std::memory_order_acquire);
+        for (; tail < head; tail++) {
+            std::fwrite(&ring->records[tail % ring->capacity], sizeof(Sample_record), 1, temp_file);
+            drained++;
+        }
+        ring->tail.store(tail, std::memory_order_release);
+
+        if (owner_exited) {
+            retired.push_back(ring);
+        }
+    }
+
+    recycle_rings(retired);
+    return drained;
+}
+
+struct Name_table {
+    std::mutex mutex;
+    std::deque<std::string> names;
+    std::unordered_map<std::string, uint16_t> ids;
+};
+
+static Name_table &name_table() {
+    static Name_table table;
+    return table;
+}
+
+static uint16_t intern(char const *name, char const **interned) {
+    static const std::size_t MAX_NAMES = 0xFFFF;
+    auto &table = name_table();
+    std::lock_guard<std::mutex> lock(table.mutex);
+    auto iter = table.ids.find(name);
+    if (iter == table.ids.end()) {
+        if (table.names.size() >= MAX_NAMES) {
+            // out of ids, everything past this point shares the last name
+            *interned = table.names.back().c_str();
+            return table.names.size() - 1;
+        }
+
+        table.names.emplace_back(name);
+        iter = table.ids.emplace(name, table.names.size() - 1).first;
+    }
+
+    *interned = table.names[iter->second].c_str();
+    return iter->second;
+}
+
+uint16_t intern_name(char const *name) {
+    char const *interned;
+    return intern(name, &interned);
+}
+
+struct Interned_arg {
+    uint16_t id;
+    char const *value;
+};
+
+thread_local std::unordered_map<char const *, Interned_arg> *this_thread_arg_cache = nullptr;
+
+uint16_t intern_string_arg(char const *value) {
+    if (this_thread_arg_cache == nullptr) {
+        // intentionally leaked, the cache only ever holds pointers into the name table
+        this_thread_arg_cache = new std::unordered_map<char const *, Interned_arg>();
+    }
+
+    // the same address may be reused for a different string so the cached content is checked before it is trusted
+    auto &cached = (*this_thread_arg_cache)[value];
+    if (cached.value == nullptr || std::strcmp(cached.value, value) != 0) {
+        cached.id = intern(value, &cached.value);
+    }
+
+    return cached.id;
+}
+
+static uint64_t epoch_ticks;
+static std::chrono::steady_clock::time_point epoch_time;
+static Format output_format;
+
+void output_thread_entry(char const *filename) {
+    std::chrono::milliseconds sleep_time {1};
     auto start_date = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
     std::FILE* temp_file = std::tmpfile();
-    uint record_offset = 0;
 
     while(true) {
-
-        uint record_index = record_offset % Max_sample_records;
-        volatile Sample_record *check_record = Sample_records + record_index;
-        if (check_record->type == Sample_record_type::INVALID) {
-            if (done.load()) {
+        // check done before draining so that the last pass sees everything published before shutdown
+        bool finished = done.load();
+        if (drain_rings(temp_file) == 0) {
+            if (finished) {
                 break;
-            } else {
-                std::this_thread::sleep_for(sleep_time);
-                continue;
             }
+            std::this_thread::sleep_for(sleep_time);
         }
-        record_offset++;
-        auto &ring_record = Sample_records[record_index];
-        std::fwrite(&ring_record, sizeof(ring_record), 1, temp_file);        
-        ring_record.type = Sample_record_type::INVALID;
     }
-    auto end_date = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
 
-    // print out the json tracefile using our binary temp file
-    std::ofstream profile_trace;
-    profile_trace.open(filename);
-    // print out preamble
+    Profile profile;
+    profile.end_time = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+    profile.start_time = start_date;
 
-    profile_trace 
-        << boost::format {"{ \"traceStartTime\": \"%.24s\" ,\"traceEvents\": [\n" } 
-        % std::ctime(&start_date);
+    // calibrate the tick counter against the steady clock over the whole run
+    auto end_ticks = read_ticks();
+    auto elapsed_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - epoch_time).count();
+    profile.epoch_ticks = epoch_ticks;
+    profile.ticks_per_us = elapsed_us > 0.0 ? (end_ticks - epoch_ticks) / elapsed_us : 1.0;
 
-    char const *sep = "";
-    std::rewind(temp_file);
-    Sample_record record;
-    while (std::fread(&record, sizeof(record), 1, temp_file) != 0) {
-        uint64_t record_time = std::chrono::duration_cast<std::chrono::microseconds>(record.tp - epoch).count();
-        profile_trace 
-            << sep
-            << boost::format { "{\"tid\":%s,\"pid\":%s,\"ts\":%d,\"cat\":\"P\"," }
-            % record.tid
-            % record.tid
-            % record_time
-            ;
-
-        if (record.type == Sample_record_type::BEGIN) {
-            profile_trace << "\"ph\":\"B\",\"name\":\"" << record.name << "\"}";
-        } else if (record.type == Sample_record_type::END) {
-            profile_trace << "\"ph\":\"E\"}";
+    profile.dropped_samples = 0;
+    {
+        std::lock_guard<std::mutex> lock(rings_mutex);
+        for (auto const &ring: rings) {
+            profile.dropped_samples += ring->dropped.load();
+        }
+        for (auto const &ring: free_rings) {
+            profile.dropped_samples += ring->dropped.load();
         }
+    }
 
-        sep = ",\n";
+    if (profile.dropped_samples > 0) {
+        std::cout << "Dropped " << profile.dropped_samples << " profile samples, consider a larger sample ring\n";
     }
 
-    profile_trace 
-        << boost::format {"]\n, \"traceEndTime\": \"%.24s\"" } % std::ctime(&end_date);
+    {
+        auto &table = name_table();
+        std::lock_guard<std::mutex> lock(table.mutex);
+        profile.names.assign(table.names.begin(), table.names.end());
+    }
+    profile.metadata.assign(metadata.begin(), metadata.end());
 
-    for (auto const &e: metadata) {
-        profile_trace << boost::format {",\n \"%s\":\"%s\""} % e.first % e.second;
+    profile.records.resize(std::ftell(temp_file) / sizeof(Sample_record));
+    std::rewind(temp_file);
+    profile.records.resize(std::fread(profile.records.data(), sizeof(Sample_record), profile.records.size(), temp_file));
+    std::fclose(temp_file);
+
+    if (output_format == Format::BINARY) {
+        std::FILE *profile_file = std::fopen(filename, "wb");
+        if (profile_file == nullptr || !write_binary(profile_file, profile)) {
+            std::cerr << "Failed to write profile " << filename << "\n";
+        }
+        if (profile_file != nullptr) {
+            std::fclose(profile_file);
+        }
+    } else {
+        std::ofstream profile_trace;
+        profile_trace.open(filename);
+        write_chrome_json(profile_trace, profile);
+        profile_trace.close();
     }
-        
-    profile_trace << "}";
-    profile_trace.close();
 }
 
-bool init(char const *filename, uint num_sample_records) {
-    auto epoch = std::chrono::steady_clock::now();
+bool init(char const *filename, uint num_sample_records, Format format) {
+    epoch_time = std::chrono::steady_clock::now();
+    epoch_ticks = read_ticks();
+    output_format = format;
     Max_sample_records = num_sample_records;
-    Sample_records = new Sample_record[num_sample_records];
-    output_thread = new std::thread(output_thread_entry, filename, epoch);
+    output_thread = new std::thread(output_thread_entry, filename);
     return true;
 }
 
-Sample_record &get_record() {
-    uint offset = write_record_offset.fetch_add(1);
-    uint index = offset % Max_sample_records;
+Sample_record *acquire_record(Sample_record_type type) {
+    auto &ring = get_thread_ring();
 
-    volatile Sample_record *check_record = Sample_records + index;
-    while (check_record->type != Sample_record_type::INVALID) {
-        // spin lock waiting for the I/O thread to catch up
+    // once a BEGIN has been dropped, drop everything until its matching END so the trace stays balanced
+    if (ring.suppressed_depth > 0) {
+        ring.suppressed_depth += (type == Sample_record_type::BEGIN) ? 1 : -1;
+        ring.dropped.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
     }
 
-    return Sample_records[index];
+    // a BEGIN must leave room for its own END and those of every scope already open, so ENDs are never dropped
+    uint64_t required = (type == Sample_record_type::BEGIN) ? ring.open_depth + 2 : 1;
+    uint64_t head = ring.head.load(std::memory_order_relaxed);
+    if (ring.capacity - (head - ring.cached_tail) < required) {
+        ring.cached_tail = ring.tail.load(std::memory_order_acquire);
+        if (ring.capacity - (head - ring.cached_tail) < required) {
+            if (type == Sample_record_type::BEGIN) {
+                ring.suppressed_depth = 1;
+            }
+            ring.dropped.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+    }
+
+    if (type == Sample_record_type::BEGIN) {
+        ring.open_depth++;
+    } else if (ring.open_depth > 0) {
+        ring.open_depth--;
+    }
+
+    auto &record = ring.records[head % ring.capacity];
+    record.tid = ring.tid;
+    record.type = type;
+    return &record;
+}
+
+void commit_record() {
+    auto &ring = *this_thread_ring;
+    ring.head.store(ring.head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
 }
 
 void shutdown() {
     done.store(true);
     std::cout << "Finalizing Trace Data\n";
     output_thread->join();
-    delete(Sample_records);
     delete(output_thread);
 }
 
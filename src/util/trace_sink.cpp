@@ -0,0 +1,205 @@
+#include <iostream>
+#include "util/trace_sink.hpp"
+
+namespace sched_bench { namespace util {
+
+bool Trace_sink::parse_format(std::string const &name, Format &format) {
+    if (name == "json") {
+        format = Format::JSON;
+    } else if (name == "binary") {
+        format = Format::BINARY;
+    } else if (name == "none") {
+        format = Format::NONE;
+    } else {
+        return false;
+    }
+
+    return true;
+}
+
+char const *Trace_sink::format_name(Format format) {
+    switch (format) {
+        case Format::JSON: return "json";
+        case Format::BINARY: return "binary";
+        default: return "none";
+    }
+}
+
+char const *Trace_sink::extension(Format format) {
+    switch (format) {
+        case Format::JSON: return ".trace";
+        case Format::BINARY: return ".trace.bin";
+        default: return "";
+    }
+}
+
+Trace_sink::Trace_sink(std::string const &basename, Format _format, uint _buffer_size, uint buffer_count)
+    : format(_format)
+    , buffer_size(_buffer_size)
+    , file(nullptr)
+    , events_written(false)
+    , properties_written(false)
+    , closed(false)
+    , current(nullptr)
+    , closing(false)
+{
+    if (format == Format::NONE) {
+        return;
+    }
+
+    file = std::fopen((basename + extension(format)).c_str(), "wb");
+    if (file == nullptr) {
+        std::cerr << "Unable to open trace file for " << basename << ", tracing disabled\n";
+        format = Format::NONE;
+        return;
+    }
+
+    buffers.resize(std::max(2u, buffer_count));
+    for (auto &b: buffers) {
+        b.data.reset(new char[buffer_size]);
+        b.size = 0;
+        free_buffers.push_back(&b);
+    }
+
+    current = free_buffers.back();
+    free_buffers.pop_back();
+    writer = std::thread(&Trace_sink::writer_entry, this);
+
+    if (format == Format::JSON) {
+        write_literal("{ \"traceEvents\": [\n");
+    } else {
+        write_literal("SBTRACE1");
+    }
+}
+
+Trace_sink::~Trace_sink() {
+    close();
+}
+
+void Trace_sink::write_string(char const *str, uint length) {
+    while (length > 0) {
+        uint available = buffer_size - current->size;
+        if (available == 0) {
+            swap_buffers();
+            continue;
+        }
+
+        uint chunk = std::min(length, available);
+        std::memcpy(current->data.get() + current->size, str, chunk);
+        current->size += chunk;
+        str += chunk;
+        length -= chunk;
+    }
+}
+
+void Trace_sink::write_property(char const *key, char const *value, bool quoted) {
+    if (format == Format::NONE) {
+        return;
+    }
+
+    uint key_length = std::strlen(key);
+    uint value_length = std::strlen(value);
+    if (format == Format::JSON) {
+        reserve(8);
+        if (!properties_written) {
+            write_literal("\n]");
+        }
+        write_literal(",\n\"");
+        write_string(key, key_length);
+        reserve(8);
+        write_literal("\":");
+        if (quoted) {
+            write_char('"');
+        }
+        write_string(value, value_length);
+        reserve(8);
+        if (quoted) {
+            write_char('"');
+        }
+    } else {
+        reserve(1 + 4);
+        write_raw<uint8_t>(3);
+        write_raw<uint32_t>(key_length);
+        write_string(key, key_length);
+        reserve(4);
+        write_raw<uint32_t>(value_length);
+        write_string(value, value_length);
+    }
+
+    properties_written = true;
+}
+
+void Trace_sink::add_property(char const *key, char const *value) {
+    write_property(key, value, true);
+}
+
+void Trace_sink::add_property(char const *key, double value) {
+    char buf[64];
+    std::snprintf(buf, sizeof(buf), "%f", value);
+    write_property(key, buf, false);
+}
+
+void Trace_sink::add_property(char const *key, uint value) {
+    write_property(key, std::to_string(value).c_str(), false);
+}
+
+void Trace_sink::add_property(char const *key, bool value) {
+    write_property(key, value ? "true" : "false", false);
+}
+
+void Trace_sink::swap_buffers() {
+    std::unique_lock<std::mutex> lock(mutex);
+    full_buffers.push_back(current);
+    writer_wakeup.notify_one();
+    producer_wakeup.wait(lock, [this]() { return !free_buffers.empty(); });
+    current = free_buffers.back();
+    free_buffers.pop_back();
+}
+
+void Trace_sink::writer_entry() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        writer_wakeup.wait(lock, [this]() { return !full_buffers.empty() || closing; });
+        if (full_buffers.empty()) {
+            break;
+        }
+
+        Buffer *buffer = full_buffers.front();
+        full_buffers.pop_front();
+        lock.unlock();
+        std::fwrite(buffer->data.get(), 1, buffer->size, file);
+        buffer->size = 0;
+        lock.lock();
+        free_buffers.push_back(buffer);
+        producer_wakeup.notify_one();
+    }
+}
+
+void Trace_sink::close() {
+    if (closed || format == Format::NONE) {
+        closed = true;
+        return;
+    }
+
+    if (format == Format::JSON) {
+        reserve(8);
+        if (!properties_written) {
+            write_literal("\n]");
+        }
+        write_literal("\n}");
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        full_buffers.push_back(current);
+        current = nullptr;
+        closing = true;
+    }
+    writer_wakeup.notify_one();
+    writer.join();
+
+    std::fclose(file);
+    closed = true;
+}
+
+}}